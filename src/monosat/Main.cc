@@ -26,6 +26,8 @@
 #include <signal.h>
 #include <zlib.h>
 #include <sstream>
+#include <cerrno>
+#include <cmath>
 #include "utils/System.h"
 #include "utils/ParseUtils.h"
 #include "utils/Options.h"
@@ -43,7 +45,12 @@
 #include "amo/AMOParser.h"
 #include "core/Optimize.h"
 #include "core/Config.h"
+#include "core/ClauseExchange.h"
+#include "core/BinaryGNF.h"
 #include "pb/Config_pb.h"
+#if not defined(__MINGW32__)
+#include <sys/wait.h>
+#endif
 using namespace Monosat;
 using namespace std;
 //=================================================================================================
@@ -170,6 +177,8 @@ void selectAlgorithms(){
 		reachalg = ReachAlg::ALG_SAT;
 	} else if (!strcasecmp(opt_reach_alg, "ramal-reps")) {
 		reachalg = ReachAlg::ALG_RAMAL_REPS;
+	} else if (!strcasecmp(opt_reach_alg, "dynamic")) {
+		reachalg = ReachAlg::ALG_DYNAMIC;
 	} else {
 		fprintf(stderr, "Error: unknown reachability algorithm %s, aborting\n", ((string) opt_reach_alg).c_str());
 		exit(1);
@@ -455,10 +464,111 @@ void processDecidable(SimpSolver & S, string dstr){
 
 
 
+#if not defined(__MINGW32__)
+//Choose the number of portfolio workers, bounded by the number of cores and by the memory available to hold a copy of
+//the (already parsed) instance for each worker. Workers share the parsed instance copy-on-write, but over a long run
+//each one will eventually touch most of its solver's memory.
+static int portfolioWorkerCount(int requested){
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	int n_workers = requested > 0 ? requested : (cores > 0 ? cores : 1);
+	double worker_mem = memUsed();
+	double avail_mem = ((double) sysconf(_SC_AVPHYS_PAGES)) * ((double) sysconf(_SC_PAGESIZE)) / (1024 * 1024);
+	if (worker_mem > 0 && avail_mem > 0) {
+		int fits = (int) (avail_mem / (worker_mem * 1.5));
+		if (fits < 1)
+			fits = 1;
+		if (fits < n_workers) {
+			if (opt_verb > 0)
+				printf("Limiting portfolio to %d workers (%.2f MB available, %.2f MB per worker)\n", fits, avail_mem, worker_mem);
+			n_workers = fits;
+		}
+	}
+	return n_workers;
+}
+
+//Give each portfolio worker a different search configuration. Worker 0 keeps the configuration selected on the command line.
+//Graph detector algorithms are chosen while the instance is parsed, and so are shared by all workers.
+static void diversifyPortfolioWorker(SimpSolver & S, int worker){
+	if (worker == 0)
+		return;
+	S.random_seed = fmod(opt_random_seed + 104729.0 * worker, 2147483646.0) + 1;
+	switch (worker % 4) {
+	case 1:
+		//geometric instead of luby restarts
+		S.luby_restart = !S.luby_restart;
+		S.restart_first = 100;
+		S.restart_inc = 1.5;
+		break;
+	case 2:
+		S.random_var_freq = 0.02;
+		S.var_decay = 0.9;
+		opt_rnd_phase = true;
+		break;
+	case 3:
+		//theory decisions on/off
+		opt_decide_theories = !opt_decide_theories;
+		S.restart_first = 50;
+		break;
+	default:
+		S.phase_saving = 1;
+		S.var_decay = 0.99;
+		S.ccmin_mode = 1;
+		break;
+	}
+}
+
+//Fork n_workers copies of this process, each of which solves the instance from this point on.
+//Returns the worker index in each child. The parent waits for the first worker to find an answer, stops the others,
+//and then exits with that worker's exit code (the winning worker prints the solution itself).
+static int forkPortfolio(int n_workers){
+	fflush(stdout);
+	fflush(stderr);
+	vec<pid_t> workers;
+	for (int i = 0; i < n_workers; i++) {
+		pid_t pid = fork();
+		if (pid == 0) {
+			return i;
+		} else if (pid < 0) {
+			fprintf(stderr, "Failed to start portfolio worker %d\n", i);
+			if (i == 0)
+				exit(1);
+			break;
+		}
+		workers.push(pid);
+	}
+	int result = 0;
+	int remaining = workers.size();
+	while (remaining > 0) {
+		int status = 0;
+		pid_t pid = wait(&status);
+		if (pid < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		remaining--;
+		if (WIFEXITED(status) && (WEXITSTATUS(status) == 10 || WEXITSTATUS(status) == 20)) {
+			result = WEXITSTATUS(status);
+			break;
+		}
+	}
+	for (pid_t pid : workers) {
+		kill(pid, SIGKILL);
+	}
+	while (wait(nullptr) > 0 || errno == EINTR) {
+	}
+	if (result == 0) {
+		printf("UNKNOWN\n");
+	}
+	fflush(stdout);
+	_exit(result);
+}
+#endif
+
 int main(int argc, char** argv) {
 	try {
 		setUsageHelp(
-				"USAGE: %s [options] <input-file> <result-output-file>\n\n  where input may be either in plain or gzipped DIMACS.\n");
+				"USAGE: %s [options] <input-file> <result-output-file>\n\n  where input may be either in plain, gzipped, or binary GNF.\n");
 
 		// Extra options:
 
@@ -492,10 +602,20 @@ int main(int argc, char** argv) {
 				"Solve geometry using precise rational arithmetic (instead of unsound, but faster, floating point arithmetic)",
 				true);
 
+		StringOption opt_write_binary("MAIN", "write-binary",
+				"Convert the input GNF to binary GNF (which is memory mapped when loaded), write it to this file, and exit", "");
+
 		BoolOption opt_ignore_solve_statements("MAIN","ignore-solves","Ignore any solve statements in the GNF",false);
 
 		IntOption opt_conflict_limit("MAIN","conflict-limit","",0,IntRange(0,INT32_MAX));
 
+		IntOption opt_portfolio("MAIN", "portfolio",
+				"Solve with this many diversified solver processes in parallel, reporting the first answer found (1 to disable, 0 to use one per core, subject to available memory)",
+				1, IntRange(0, 1024));
+		IntOption opt_portfolio_share("MAIN", "portfolio-share",
+				"Share learnt clauses up to this length between portfolio workers (0 to disable clause sharing)", 8,
+				IntRange(0, 1024));
+
 		parseOptions(argc, argv, true);
 		Monosat::opt_record=strlen(opt_record_file)>0;
 
@@ -576,9 +696,43 @@ int main(int argc, char** argv) {
 		if (!opt_pre)
 			S.eliminate(true);
 
-		gzFile in = (argc == 1) ? gzdopen(0, "rb") : gzopen(argv[1], "rb");
-		if (in == NULL)
-			printf("ERROR! Could not open file: %s\n", argc == 1 ? "<stdin>" : argv[1]), exit(1);
+		gzFile in = nullptr;
+		BinaryGNFReader * binary_in = nullptr;
+		if (argc > 1 && BinaryGNF::isBinaryFile(argv[1])) {
+			//binary GNF is memory mapped, rather than streamed
+			try {
+				binary_in = new BinaryGNFReader(argv[1]);
+			} catch (const std::exception & e) {
+				printf("%s\n", e.what()), exit(1);
+			}
+		} else {
+			in = (argc == 1) ? gzdopen(0, "rb") : gzopen(argv[1], "rb");
+			if (in == NULL)
+				printf("ERROR! Could not open file: %s\n", argc == 1 ? "<stdin>" : argv[1]), exit(1);
+		}
+
+		if (strlen(opt_write_binary) > 0) {
+			if (!in)
+				printf("ERROR! Input is already in binary GNF format\n"), exit(1);
+			FILE * out = fopen(opt_write_binary, "wb");
+			if (!out)
+				printf("ERROR! Could not open file: %s\n", (const char*) opt_write_binary), exit(1);
+			BinaryGNFWriter writer(out);
+			std::vector<char> buf(1 << 20);
+			int n;
+			while ((n = gzread(in, buf.data(), buf.size())) > 0) {
+				writer.write(buf.data(), n);
+			}
+			writer.close();
+			if (fclose(out) != 0 || n < 0)
+				printf("ERROR! Failed to convert to binary GNF\n"), exit(1);
+			gzclose(in);
+			if (opt_verb > 0) {
+				printf("Wrote %ld clauses, %ld edges, and %ld other lines to %s (%f s)\n", writer.stats_clauses,
+						writer.stats_edges, writer.stats_lines, (const char*) opt_write_binary, rtime(0) - initial_time);
+			}
+			exit(0);
+		}
 
 		if (opt_verb > 0) {
 			printf("============================[ Problem Statistics ]=============================\n");
@@ -623,10 +777,10 @@ int main(int argc, char** argv) {
 #endif
 		vec<Lit> assume;
 
-		StreamBuffer strm(in);
+		StreamBuffer * strm = in ? new StreamBuffer(in) : nullptr;
 		bool found_optimal=true;
-		while(S.okay() && parser.parse(strm, S)){
-			if(*strm==EOF){
+		while(S.okay() && (binary_in ? parser.parse(*binary_in, S) : parser.parse(*strm, S))){
+			if(binary_in ? binary_in->eof() : **strm==EOF){
 				//Don't run solves from the last line of the file, in order to support pre-processing and other options below.
 				//(This is not a great way to deal with preprocessing...)
 				break;
@@ -641,7 +795,12 @@ int main(int argc, char** argv) {
 				parser.assumptions.clear();
 			}
 		}
-		gzclose(in);
+		if (in) {
+			delete strm;
+			gzclose(in);
+		} else {
+			delete binary_in;
+		}
 
 		vec<std::pair<int, std::string> > & symbols  = symbolParser.getSymbols();
 		processSymbols( symbols,assume,opt_assume,opt_assume_symbols, using_symbols_asp);
@@ -689,9 +848,31 @@ int main(int argc, char** argv) {
 			fflush(stdout);
 		}
 
-
+		ClauseExchange * exchange = nullptr;
+#if not defined(__MINGW32__)
+		if (opt_portfolio != 1 && S.okay()) {
+			int n_workers = portfolioWorkerCount(opt_portfolio);
+			if (n_workers > 1) {
+				//Learnt clauses are only implied by the formula if there are no objectives (optimization adds bounding constraints)
+				int share_length = parser.objectives.size() ? 0 : (int) opt_portfolio_share;
+				exchange = new ClauseExchange(n_workers, share_length);
+				if (opt_verb > 0)
+					printf("Starting portfolio of %d workers\n", n_workers);
+				int worker = forkPortfolio(n_workers);
+				exchange->setWorker(worker, S.nVars());
+				diversifyPortfolioWorker(S, worker);
+				if (share_length > 0)
+					S.setClauseExchange(exchange);
+			}
+		}
+#endif
 
 		lbool ret = optimize_and_solve(S,parser.assumptions,parser.objectives,false,found_optimal);
+		if (exchange && (ret == l_Undef || !exchange->claimWinner())) {
+			//another worker either already reported a result, or may still find one
+			fflush(stdout);
+			_exit(0);
+		}
 		double solving_time = rtime(0) - after_preprocessing;
 		if (opt_verb > 0) {
 			printf("Solving time = %f\n", solving_time);
@@ -24,15 +24,37 @@
 
 #include "monosat/core/SolverTypes.h"
 #include "monosat/mtl/Vec.h"
+#include "monosat/mtl/Sort.h"
+#include <cstdint>
 #include <list>
+#include <map>
+#include <unordered_map>
+#include <vector>
 
 namespace Monosat{
 
 //Barebones helper methods for expressing combinatorial logic in CNF.
+//Gates are structurally hashed (in the style of an and-inverter graph): two-input And/Or gates are normalized to
+//an And over sorted inputs, Xor gates to an Xor over positive inputs, and building the same gate twice returns the
+//same literal. Constants, duplicated and complementary inputs, and one level of absorption (eg, a & (a & b) = a & b,
+//a & ~(~a & b) = a) are folded away without introducing new variables.
 template<class Solver>
 class Circuit{
 	Solver & S;
 	Lit lit_True=lit_Undef;
+	bool hashing=true;
+	std::unordered_map<uint64_t,Lit> and_gates;
+	std::unordered_map<uint64_t,Lit> xor_gates;
+	std::map<std::vector<int>,Lit> nary_and_gates;
+	//the (sorted) inputs of each variable that is the positive output of a two-input And gate
+	vec<Lit> gate_in_a;
+	vec<Lit> gate_in_b;
+	std::vector<int> key;
+public:
+	long stats_gates_created=0;
+	long stats_gates_reused=0;
+	long stats_gates_simplified=0;
+private:
 
 	bool isConst(Lit l){
 		return isConstTrue(l) || isConstFalse(l);
@@ -46,8 +68,135 @@ class Circuit{
 	}
 	vec<Lit> tmp;
 	vec<Lit> tmp2;
+	vec<Lit> tmp_neg;
 	vec<Lit> clause;
 	vec<Lit> store;
+
+	//Gate outputs that were eliminated by preprocessing can no longer be used in new constraints.
+	template<class S2>
+	static auto eliminated(S2 & solver, Var v, int) -> decltype(solver.isEliminated(v)){
+		return solver.isEliminated(v);
+	}
+	template<class S2>
+	static bool eliminated(S2 & solver, Var v, long){
+		return false;
+	}
+	static uint64_t gateKey(Lit a, Lit b){
+		return (((uint64_t)toInt(a))<<32) | (uint32_t)toInt(b);
+	}
+	template<class Map, class Key>
+	Lit lookup(Map & table, const Key & k){
+		auto it = table.find(k);
+		if(it==table.end())
+			return lit_Undef;
+		if(eliminated(S,var(it->second),0)){
+			table.erase(it);
+			return lit_Undef;
+		}
+		stats_gates_reused++;
+		return it->second;
+	}
+
+	bool isAndGate(Lit l){
+		return !sign(l) && var(l)<gate_in_a.size() && gate_in_a[var(l)]!=lit_Undef;
+	}
+
+	//Returns the literal equivalent to (a AND b) if it can be found without creating a new gate, and lit_Undef otherwise.
+	//a and b are sorted on return.
+	Lit simplifyAnd(Lit & a, Lit & b){
+		if (isConstFalse(a) || isConstFalse(b)){
+			return getFalse();
+		}else if (isConstTrue(a)){
+			return b;
+		}else if (isConstTrue(b)){
+			return a;
+		}
+		if(!hashing)
+			return lit_Undef;
+		if(a==b){
+			stats_gates_simplified++;
+			return a;
+		}else if(a==~b){
+			stats_gates_simplified++;
+			return getFalse();
+		}
+		if(toInt(b)<toInt(a))
+			std::swap(a,b);
+		for(int i = 0;i<2;i++){
+			Lit g = i==0 ? a:b;
+			Lit o = i==0 ? b:a;
+			if(isAndGate(g)){
+				Lit x = gate_in_a[var(g)];
+				Lit y = gate_in_b[var(g)];
+				if(o==x || o==y){
+					//(x & y) & x = (x & y)
+					stats_gates_simplified++;
+					return g;
+				}else if (o==~x || o==~y){
+					//(x & y) & ~x = false
+					stats_gates_simplified++;
+					return getFalse();
+				}
+			}else if (isAndGate(~g)){
+				Lit x = gate_in_a[var(g)];
+				Lit y = gate_in_b[var(g)];
+				if(o==~x || o==~y){
+					//~(x & y) & ~x = ~x
+					stats_gates_simplified++;
+					return o;
+				}
+			}
+		}
+		return lookup(and_gates,gateKey(a,b));
+	}
+
+	void recordAnd(Lit a, Lit b, Lit out){
+		stats_gates_created++;
+		if(!hashing)
+			return;
+		and_gates[gateKey(a,b)]=out;
+		if(!sign(out)){
+			gate_in_a.growTo(var(out)+1,lit_Undef);
+			gate_in_b.growTo(var(out)+1,lit_Undef);
+			if(gate_in_a[var(out)]==lit_Undef){
+				gate_in_a[var(out)]=a;
+				gate_in_b[var(out)]=b;
+			}
+		}
+	}
+
+	//Returns the literal equivalent to (a XOR b) if it can be found without creating a new gate, and lit_Undef otherwise.
+	//On return, a and b are positive and sorted, and parity is true if the gate's output must be negated.
+	Lit simplifyXor(Lit & a, Lit & b, bool & parity){
+		parity=false;
+		if (isConstTrue(a)){
+			return ~b;
+		}else if (isConstFalse(a)){
+			return b;
+		}else if (isConstTrue(b)){
+			return ~a;
+		}else if (isConstFalse(b)){
+			return a;
+		}
+		if(!hashing)
+			return lit_Undef;
+		if(a==b){
+			stats_gates_simplified++;
+			return getFalse();
+		}else if(a==~b){
+			stats_gates_simplified++;
+			return getTrue();
+		}
+		parity = sign(a)!=sign(b);
+		a = mkLit(var(a));
+		b = mkLit(var(b));
+		if(toInt(b)<toInt(a))
+			std::swap(a,b);
+		Lit r = lookup(xor_gates,gateKey(a,b));
+		if(r!=lit_Undef && parity)
+			return ~r;
+		return r;
+	}
 	template<typename... Args>
 	void collect(vec<Lit> & store, Lit a, Args... args ){
 		store.push(a);
@@ -82,11 +231,19 @@ class Circuit{
 	}
 public:
 
-	Circuit(Solver & S):S(S){
+	Circuit(Solver & S, bool structuralHashing=true):S(S),hashing(structuralHashing){
 		lit_True = mkLit(S.newVar());
 		S.addClause(lit_True);
 	}
 
+	//Enable or disable structural hashing of new gates (gates that were already built remain shared).
+	void setStructuralHashing(bool enable){
+		hashing=enable;
+	}
+	bool structuralHashing()const{
+		return hashing;
+	}
+
 	Solver & getSolver(){
 		return S;
 	}
@@ -104,48 +261,18 @@ public:
 	}
 
 	Lit And_(Lit a, Lit b, Lit out){
-		//special case these
-		if(isConst(a) || isConst(b)){
-			if(isConstTrue(a) && isConstTrue(b)){
-				if(out!=lit_Undef) {
-					Assert(out);
-				}
-				return getTrue();
-			}else if (isConstFalse(a) || isConstFalse(b)){
-				if(out!=lit_Undef) {
-					Assert(~out);
-				}
-				return getFalse();
-			}
-
-			if (isConstFalse(a)){
-				if(out!=lit_Undef) {
-					Assert(~out);
-				}
-				return getFalse();
-			}else if (isConstFalse(b)){
-				if(out!=lit_Undef) {
-					Assert(~out);
-				}
-				return getFalse();
-			}else if (isConstTrue(a)){
-				if(out!=lit_Undef) {
-					AssertEqual(b,out);
-				}
-				return b;
-			}else if (isConstTrue(b)){
-				if(out!=lit_Undef) {
-					AssertEqual(a,out);
-				}
-				return a;
-			}
-		}
 		if(out==lit_Undef){
-			out = mkLit(S.newVar());
+			return And(a,b);
+		}
+		Lit r = simplifyAnd(a,b);
+		if(r!=lit_Undef){
+			AssertEqual(r,out);
+			return r;
 		}
 		S.addClause(a,~out);
 		S.addClause(b,~out);
 		S.addClause(~a,~b,out);
+		recordAnd(a,b,out);
 		return out;
 	}
 
@@ -164,6 +291,7 @@ public:
 				if(out!=lit_Undef){
 					Assert(~out);
 				}
+				tmp.clear();
 				return getFalse();
 			}else if (isConstTrue(l)){
 				//leave literal out
@@ -171,6 +299,26 @@ public:
 				tmp.push(l);
 			}
 		}
+		if(hashing && tmp.size()>1){
+			//sort the inputs, and remove duplicates; complementary inputs are adjacent after sorting
+			sort(tmp);
+			int j = 1;
+			for(int i = 1;i<tmp.size();i++){
+				if(tmp[i]==tmp[j-1]){
+					stats_gates_simplified++;
+				}else if (tmp[i]==~tmp[j-1]){
+					stats_gates_simplified++;
+					tmp.clear();
+					if(out!=lit_Undef){
+						Assert(~out);
+					}
+					return getFalse();
+				}else{
+					tmp[j++]=tmp[i];
+				}
+			}
+			tmp.shrink(tmp.size()-j);
+		}
 		//all arguments are constant true
 		if(tmp.size()==0){
 			if(out!=lit_Undef){
@@ -178,14 +326,38 @@ public:
 			}
 			return getTrue();
 		}else if (tmp.size()==1){
+			Lit a = tmp[0];
+			tmp.clear();
 			if(out!=lit_Undef){
-				AssertEqual(tmp[0],out);
+				AssertEqual(a,out);
+			}
+			return a;
+		}else if (tmp.size()==2){
+			Lit a = tmp[0];
+			Lit b = tmp[1];
+			tmp.clear();
+			return And_(a,b,out);
+		}
+		if(hashing){
+			key.clear();
+			for(Lit l:tmp)
+				key.push_back(toInt(l));
+			Lit r = lookup(nary_and_gates,key);
+			if(r!=lit_Undef){
+				tmp.clear();
+				if(out!=lit_Undef){
+					AssertEqual(r,out);
+				}
+				return r;
 			}
-			return tmp[0];
 		}
 		if(out==lit_Undef){
 			out = mkLit(S.newVar());
 		}
+		if(hashing){
+			nary_and_gates[key]=out;
+		}
+		stats_gates_created++;
 		for(Lit l:tmp){
 			S.addClause(l,~out);
 		}
@@ -200,23 +372,14 @@ public:
 
 
 	Lit And(Lit a, Lit b){
-		//special case these
-		if(isConst(a) || isConst(b)){
-			if (isConstTrue(a)){
-				return b;
-			}else if (isConstFalse(a)){
-				return a;
-			}else if (isConstTrue(b)){
-				return a;
-			}else if (isConstFalse(b)){
-				return b;
-			}
-		}
-
+		Lit r = simplifyAnd(a,b);
+		if(r!=lit_Undef)
+			return r;
 		Lit out = mkLit(S.newVar());
 		S.addClause(a,~out);
 		S.addClause(b,~out);
 		S.addClause(~a,~b,out);
+		recordAnd(a,b,out);
 		return out;
 	}
 	Lit And(const std::list<Lit> & vals){
@@ -247,107 +410,22 @@ public:
 		return a;
 	}
 
+	//Or gates are stored as negated And gates, so that a | b and ~(~a & ~b) share a single gate.
 	Lit Or(Lit a, Lit b){
-		if(isConstTrue(a)){
-			return getTrue();
-		}else if (isConstTrue(b)){
-			return getTrue();
-		}else if(isConstFalse(a)){
-			return b;
-		}else if (isConstFalse(b)){
-			return a;
-		}
-
-		Lit out = mkLit(S.newVar());
-		S.addClause(~a,out);
-		S.addClause(~b,out);
-		S.addClause(a,b,~out);
-		return out;
+		return ~And(~a,~b);
 	}
 	Lit Or_(Lit a, Lit b, Lit out){
-
-		//special case these
-		if(isConst(a) || isConst(b)){
-
-			if(isConstFalse(a) && isConstFalse(b)){
-				if(out!=lit_Undef) {
-					Assert(~out);
-				}
-				return getFalse();
-			}else if (isConstTrue(a) || isConstTrue(b)){
-				if(out!=lit_Undef) {
-					Assert(out);
-				}
-				return getTrue();
-			}
-
-			if (isConstTrue(a)){
-				if(out!=lit_Undef) {
-					Assert(out);
-				}
-				return getTrue();
-			}else if (isConstTrue(b)){
-				if(out!=lit_Undef) {
-					Assert(out);
-				}
-				return getTrue();
-			}else if (isConstFalse(a)){
-				if(out!=lit_Undef) {
-					AssertEqual(b,out);
-				}
-				return b;
-			}else if (isConstFalse(b)){
-				if(out!=lit_Undef) {
-					AssertEqual(a,out);
-				}
-				return a;
-			}
-		}
 		if(out==lit_Undef){
-			out = mkLit(S.newVar());
+			return Or(a,b);
 		}
-		S.addClause(~a,out);
-		S.addClause(~b,out);
-		S.addClause(a,b,~out);
-		return out;
+		return ~And_(~a,~b,~out);
 	}
 	Lit Or_(const vec<Lit> & vals, Lit out){
-		assert(tmp.size()==0);
+		tmp_neg.clear();
 		for(Lit l:vals){
-			if (isConstFalse(l)){
-				//leave literal out
-			}else if (isConstTrue(l)){
-				if(out!=lit_Undef){
-					Assert(out);
-				}
-				return getTrue();
-			}else{
-				tmp.push(l);
-			}
+			tmp_neg.push(~l);
 		}
-		//all arguments are constant false
-		if(tmp.size()==0){
-			if(out!=lit_Undef){
-				Assert(~out);
-			}
-			return getFalse();//or should this be true?
-		}else if (tmp.size()==1){
-			if(out!=lit_Undef){
-				AssertEqual(tmp[0],out);
-			}
-			return tmp[0];
-		}
-		if(out==lit_Undef){
-			out = mkLit(S.newVar());
-		}
-		for(Lit l:tmp){
-			S.addClause(~l,out);
-		}
-
-		tmp.push(~out);
-		S.addClause(tmp);
-		tmp.clear();
-		return out;
+		return ~And_(tmp_neg, out==lit_Undef ? lit_Undef : ~out);
 	}
 
 	Lit Or(const std::list<Lit> & vals){
@@ -431,58 +509,42 @@ public:
 	}
 
 	Lit Xor(Lit a, Lit b){
-		if(isConst(a) || isConst(b)){
-			if (isConstTrue(a)){
-				return ~b;
-			}else if (isConstFalse(a)){
-				return b;
-			}else if (isConstTrue(b)){
-				return ~a;
-			}else if (isConstFalse(b)){
-				return a;
-			}
-		}
+		bool parity;
+		Lit r = simplifyXor(a,b,parity);
+		if(r!=lit_Undef)
+			return r;
 		//return Or(And(a, ~b), And(~a,b));
 		Lit out = mkLit(S.newVar());
 		S.addClause(a,b,~out);
 		S.addClause(~a,b,out);
 		S.addClause(a,~b,out);
 		S.addClause(~a,~b,~out);
-		return out;
+		stats_gates_created++;
+		if(hashing)
+			xor_gates[gateKey(a,b)]=out;
+		return parity ? ~out:out;
 	}
 	Lit Xor_(Lit a, Lit b, Lit out){
-		if(isConst(a) || isConst(b)){
-			if (isConstTrue(a)){
-				if(out!=lit_Undef){
-					AssertEqual(~b,out);
-				}
-				return ~b;
-			}else if (isConstFalse(a)){
-				if(out!=lit_Undef){
-					AssertEqual(b,out);
-				}
-				return b;
-			}else if (isConstTrue(b)){
-				if(out!=lit_Undef){
-					AssertEqual(~a,out);
-				}
-				return ~a;
-			}else if (isConstFalse(b)){
-				if(out!=lit_Undef){
-					AssertEqual(a,out);
-				}
-				return a;
-			}
+		if(out==lit_Undef){
+			return Xor(a,b);
 		}
-		//return Or(And(a, ~b), And(~a,b));
-		if(out!=lit_Undef){
-			out = mkLit(S.newVar());
+		bool parity;
+		Lit r = simplifyXor(a,b,parity);
+		if(r!=lit_Undef){
+			AssertEqual(r,out);
+			return r;
 		}
+		//after normalizing a and b, out = a XOR b XOR parity
+		if(parity)
+			out=~out;
 		S.addClause(a,b,~out);
 		S.addClause(~a,b,out);
 		S.addClause(a,~b,out);
 		S.addClause(~a,~b,~out);
-		return out;
+		stats_gates_created++;
+		if(hashing)
+			xor_gates[gateKey(a,b)]=out;
+		return parity ? ~out:out;
 	}
 	Lit Xor(const std::list<Lit> & vals){
 		tmp.clear();
@@ -516,7 +578,7 @@ public:
 		return ~Xor(a,b);
 	}
 	Lit Xnor_(Lit a, Lit b, Lit out){
-		return ~Xnor(a,b,out);
+		return ~Xor_(a,b,out==lit_Undef ? lit_Undef : ~out);
 	}
 	Lit Xnor(const std::list<Lit> & vals){
 		return ~Xor(vals);
@@ -540,6 +602,16 @@ public:
 	}
 
 	Lit Ite(Lit cond, Lit thn, Lit els){
+		if(hashing){
+			if(thn==els){
+				stats_gates_simplified++;
+				return thn;
+			}else if (thn==~els){
+				//cond ? thn : ~thn
+				stats_gates_simplified++;
+				return ~Xor(cond,thn);
+			}
+		}
 		Lit l = ~And(cond,~thn);
 		Lit r = ~And(~cond,~els);
 		return And(l,r);
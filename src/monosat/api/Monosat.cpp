@@ -30,6 +30,8 @@
 #include "monosat/amo/AMOTheory.h"
 #include "Monosat.h"
 #include "monosat/core/Dimacs.h"
+#include "monosat/core/BinaryGNF.h"
+#include "monosat/utils/AsyncWriter.h"
 #include "monosat/bv/BVParser.h"
 #include "monosat/graph/GraphParser.h"
 #include "monosat/amo/AMOParser.h"
@@ -37,6 +39,8 @@
 #include "monosat/pb/PbSolver.h"
 #include <csignal>
 #include <set>
+#include <mutex>
+#include <atomic>
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -75,6 +79,12 @@ static bool has_system_mem_limit=false;
 static rlim_t system_mem_limit;
 
 static std::set<Solver*> solvers;
+//Guards the solver set, the command line options (which are parsed into globals when a solver is created), and the resource limits,
+//so that independent solvers can be created and solved from different threads.
+static std::mutex api_mutex;
+//Set while the solver set is being modified, so that the signal handler (which cannot take the mutex) skips it.
+static std::atomic<bool> solvers_busy(false);
+static int active_solves=0;
 
 static sighandler_t system_sigxcpu_handler = nullptr;
 
@@ -97,16 +107,26 @@ static initializer i;
 }
 void disableResourceLimits();
 static void SIGNAL_HANDLER_api(int signum) {
-	disableResourceLimits();
+	//raise the soft limit, so that the signal is not repeated; the original limits are restored when the solve call returns
+	rlimit rl;
+	getrlimit(RLIMIT_CPU, &rl);
+	rl.rlim_cur = rl.rlim_max;
+	setrlimit(RLIMIT_CPU, &rl);
 	printf("Interupting solver due to resource limit\n");
 	fflush(stdout);
-	for(Solver* solver:solvers)
-		solver->interrupt();
-
+	if(!solvers_busy){
+		for(Solver* solver:solvers)
+			solver->interrupt();
+	}
 }
 
 
 void enableResourceLimits(){
+	std::lock_guard<std::mutex> lock(api_mutex);
+	if(active_solves++>0){
+		//the limits are process wide, and were already applied by a concurrent solve call
+		return;
+	}
 	struct rusage ru;
 	getrusage(RUSAGE_SELF, &ru);
 	__time_t cur_time = ru.ru_utime.tv_sec;
@@ -158,6 +178,10 @@ void enableResourceLimits(){
 }
 
 void disableResourceLimits(){
+	std::lock_guard<std::mutex> lock(api_mutex);
+	if(active_solves==0 || --active_solves>0){
+		return;
+	}
 	rlimit rl;
 	getrlimit(RLIMIT_CPU, &rl);
 	if(has_system_time_limit){
@@ -276,6 +300,8 @@ void _selectAlgorithms(){
 		reachalg = ReachAlg::ALG_SAT;
 	} else if (!strcasecmp(opt_reach_alg, "ramal-reps")) {
 		reachalg = ReachAlg::ALG_RAMAL_REPS;
+	} else if (!strcasecmp(opt_reach_alg, "dynamic")) {
+		reachalg = ReachAlg::ALG_DYNAMIC;
 	} else {
 		api_errorf( "Error: unknown reachability algorithm %s, aborting\n", ((string) opt_reach_alg).c_str());
 
@@ -365,8 +391,20 @@ struct MonosatData{
 	bool last_solution_optimal=true;
 	bool has_conflict_clause_from_last_solution=false;
 	vec<Objective> optimization_objectives;
+	OptimizationCallback optimization_callback=nullptr;
+	void * optimization_callback_data=nullptr;
 	FILE * outfile =nullptr;
+	//if the output file is in binary GNF format, all output is re-encoded through this writer
+	Monosat::BinaryGNFWriter * binary_out=nullptr;
+	//if asynchronous output is enabled, output is formatted into blocks that are written (and, if needed, re-encoded) on a background thread
+	Monosat::AsyncWriter * async_out=nullptr;
 	string args = "";
+	//Scratch buffers for the API calls, kept per solver (rather than as function statics)
+	//so that independent solvers can be used from different threads.
+	vec<Lit> tmp_lits;
+	vec<int> tmp_ints;
+	vec<Var> tmp_vars;
+	vec<PB::Int> tmp_coefs;
 };
 
 //Supporting function for throwing parse errors
@@ -377,6 +415,21 @@ inline void write_out(Monosat::SimpSolver * S, const char *fmt, ...) {
 	}
 	va_list args;
 	va_start(args, fmt);
+	if(d->async_out){
+		d->async_out->vwritef(fmt,args);
+		va_end(args);
+		return;
+	}
+	if(d->binary_out){
+		try{
+			//binary output is buffered into blocks, and only flushed at each solve call.
+			d->binary_out->vwritef(fmt,args);
+		}catch(const std::exception & e){
+			api_errorf("Failed to write output");
+		}
+		va_end(args);
+		return;
+	}
 	if( vfprintf(d->outfile,fmt,args)<0){
 		api_errorf("Failed to write output");
 	}
@@ -384,15 +437,81 @@ inline void write_out(Monosat::SimpSolver * S, const char *fmt, ...) {
 	fflush(d->outfile);
 }
 
-void setOutputFile(Monosat::SimpSolver * S, char * output){
+//Make sure that all output so far is on disk (called at each solve, so that the output can be replayed even if the solve crashes).
+inline void flush_out(Monosat::SimpSolver * S){
 	MonosatData * d = (MonosatData*) S->_external_data;
-	assert(d);
+	if (d && d->async_out){
+		if(!d->async_out->sync()){
+			api_errorf("Failed to write output");
+		}
+	}else if (d && d->binary_out){
+		try{
+			d->binary_out->flush();
+		}catch(const std::exception & e){
+			api_errorf("Failed to write output");
+		}
+	}
+}
+
+static void close_out(MonosatData * d){
+	if(d->async_out){
+		delete(d->async_out);
+		d->async_out=nullptr;
+	}
+	if(d->binary_out){
+		try{
+			d->binary_out->close();
+		}catch(const std::exception & e){
+			//nothing more can be done here
+		}
+		delete(d->binary_out);
+		d->binary_out=nullptr;
+	}
 	if(d->outfile){
 		fclose(d->outfile);
 		d->outfile=nullptr;
 	}
+}
+
+static bool is_binary_output(const char * output){
+	size_t len = strlen(output);
+	return len>=5 && strcmp(output+len-5,".gnfb")==0;
+}
+
+void setOutputFile(Monosat::SimpSolver * S, char * output){
+	MonosatData * d = (MonosatData*) S->_external_data;
+	assert(d);
+	close_out(d);
 	if (output && strlen(output)>0) {
-		d->outfile = fopen(output, "w");
+		//files ending in '.gnfb' are written in binary GNF format
+		if(is_binary_output(output)){
+			d->outfile = fopen(output, "wb");
+			if(d->outfile){
+				d->binary_out = new Monosat::BinaryGNFWriter(d->outfile);
+			}
+		}else{
+			d->outfile = fopen(output, "w");
+		}
+		if(d->outfile && opt_async_output){
+			FILE * f = d->outfile;
+			Monosat::BinaryGNFWriter * binary = d->binary_out;
+			d->async_out = new Monosat::AsyncWriter([f,binary](const char * data, size_t len){
+				if(binary){
+					binary->write(data,len);
+				}else if(fwrite(data,1,len,f)!=len){
+					throw std::runtime_error("Failed to write output");
+				}
+			},[f,binary](){
+				if(binary){
+					binary->flush();
+				}else if(fflush(f)!=0){
+					throw std::runtime_error("Failed to write output");
+				}
+#if not defined(__MINGW32__)
+				fsync(fileno(f));
+#endif
+			});
+		}
 	}
 	write_out(S,"c monosat %s\n",d->args.c_str());
 	if(S->const_true!=lit_Undef){
@@ -460,6 +579,7 @@ Monosat::SimpSolver * newSolver_args(int argc, char**argv){
 		args.append(argv[i]);
 	}
 
+	std::lock_guard<std::mutex> lock(api_mutex);
 	parseOptions(argc, argv, true);
 	if (opt_adaptive_conflict_mincut == 1) {
 		opt_conflict_min_cut = true;
@@ -473,7 +593,9 @@ Monosat::SimpSolver * newSolver_args(int argc, char**argv){
 	}
 	_selectAlgorithms();
 	Monosat::SimpSolver * S = new Monosat::SimpSolver();
+	solvers_busy=true;
 	solvers.insert(S);//add S to the list of solvers handled by signals
+	solvers_busy=false;
 
 
 	S->_external_data =(void*)new MonosatData();
@@ -489,13 +611,15 @@ void deleteSolver (Monosat::SimpSolver * S)
 {
 	using namespace APISignal;
 	S->interrupt();
-	solvers.erase(S);//remove S from the list of solvers in the signal handler
+	{
+		std::lock_guard<std::mutex> lock(api_mutex);
+		solvers_busy=true;
+		solvers.erase(S);//remove S from the list of solvers in the signal handler
+		solvers_busy=false;
+	}
 	if(S->_external_data){
 		MonosatData* data = (MonosatData*) S->_external_data;
-		if(data->outfile){
-			fclose(data->outfile);
-			data->outfile = nullptr;
-		}
+		close_out(data);
 		delete(data);
 		S->_external_data=nullptr;
 	}
@@ -536,7 +660,7 @@ void maximizeLits(Monosat::SimpSolver *  S, int * lits, int n_lits){
 	if(n_lits<=0)
 		return;
 	MonosatData * d = (MonosatData*) S->_external_data;
-	static vec<Lit> lits_opt;
+	vec<Lit> & lits_opt = d->tmp_lits;
 	lits_opt.clear();
 	for (int i = 0;i<n_lits;i++){
 		lits_opt.push(toLit(lits[i]));
@@ -553,7 +677,7 @@ void minimizeLits(Monosat::SimpSolver *  S, int * lits, int n_lits){
 	if(n_lits<=0)
 		return;
 	MonosatData * d = (MonosatData*) S->_external_data;
-	static vec<Lit> lits_opt;
+	vec<Lit> & lits_opt = d->tmp_lits;
 	lits_opt.clear();
 	for (int i = 0;i<n_lits;i++){
 		lits_opt.push(toLit(lits[i]));
@@ -570,8 +694,8 @@ void maximizeWeightedLits(Monosat::SimpSolver *  S, int * lits, int * weights, i
 	if(n_lits<=0)
 		return;
 	MonosatData * d = (MonosatData*) S->_external_data;
-	static vec<Lit> lits_opt;
-	static vec<int> weights_opt;
+	vec<Lit> & lits_opt = d->tmp_lits;
+	vec<int> & weights_opt = d->tmp_ints;
 	lits_opt.clear();
 	for (int i = 0;i<n_lits;i++){
 		lits_opt.push(toLit(lits[i]));
@@ -602,8 +726,8 @@ void minimizeWeightedLits(Monosat::SimpSolver *  S, int * lits, int * weights, i
 	if(n_lits<=0)
 		return;
 	MonosatData * d = (MonosatData*) S->_external_data;
-	static vec<Lit> lits_opt;
-	static vec<int> weights_opt;
+	vec<Lit> & lits_opt = d->tmp_lits;
+	vec<int> & weights_opt = d->tmp_ints;
 	lits_opt.clear();
 	for (int i = 0;i<n_lits;i++){
 		lits_opt.push(toLit(lits[i]));
@@ -633,9 +757,15 @@ void minimizeWeightedLits(Monosat::SimpSolver *  S, int * lits, int * weights, i
 void readGNF(Monosat::SimpSolver * S, const char  * filename){
 	bool precise = true;
 
-	gzFile in = gzopen(filename, "rb");
-	if (in == nullptr)
-		throw std::runtime_error("ERROR! Could not open file");
+	gzFile in = nullptr;
+	BinaryGNFReader * binary_in = nullptr;
+	if(BinaryGNF::isBinaryFile(filename)){
+		binary_in = new BinaryGNFReader(filename);
+	}else{
+		in = gzopen(filename, "rb");
+		if (in == nullptr)
+			throw std::runtime_error("ERROR! Could not open file");
+	}
 	MonosatData * d = (MonosatData*) S->_external_data;
 
 	Dimacs<StreamBuffer, SimpSolver> parser;
@@ -651,11 +781,11 @@ void readGNF(Monosat::SimpSolver * S, const char  * filename){
 	AMOParser<char *, SimpSolver> amo;
 	parser.addParser(&amo);
 
-	StreamBuffer strm(in);
+	StreamBuffer * strm = in ? new StreamBuffer(in) : nullptr;
 	vec<int> assumps;
 	bool ran_last_solve=false;
 	d->optimization_objectives.clear();
-	while(parser.parse(strm, *S)){
+	while(binary_in ? parser.parse(*binary_in, *S) : parser.parse(*strm, *S)){
 		assumps.clear();
 		for(Lit l:parser.assumptions){
 			assumps.push(toInt(l));
@@ -666,11 +796,11 @@ void readGNF(Monosat::SimpSolver * S, const char  * filename){
 		}
 
 		solveAssumptions(S,&assumps[0],assumps.size());
-		if(*strm==EOF){
+		if(binary_in ? binary_in->eof() : **strm==EOF){
 			ran_last_solve=true;
 		}
 	}
-	assert(*strm==EOF);
+	assert(binary_in ? binary_in->eof() : **strm==EOF);
 	if(!ran_last_solve){
 		for(Lit l:parser.assumptions){
 			assumps.push(toInt(l));
@@ -683,8 +813,12 @@ void readGNF(Monosat::SimpSolver * S, const char  * filename){
 	}
 	d->optimization_objectives.clear();
 
-	gzclose(in);
-
+	if(in){
+		delete strm;
+		gzclose(in);
+	}else{
+		delete binary_in;
+	}
 }
 
 Monosat::GraphTheorySolver<int64_t> *  newGraph(Monosat::SimpSolver * S){
@@ -750,6 +884,7 @@ int _solve(Monosat::SimpSolver * S,int * assumptions, int n_assumptions){
 		write_out(S," %d",dimacs(l));
 	}
 	write_out(S,"\n");
+	flush_out(S);
 
 	APISignal::enableResourceLimits();
 
@@ -774,7 +909,9 @@ int _solve(Monosat::SimpSolver * S,int * assumptions, int n_assumptions){
 	if (d->pbsolver) {
 		d->pbsolver->convert();
 	}
-	lbool r = optimize_and_solve(*S, assume,objectives,opt_pre,found_optimal);
+	lbool r = optimize_and_solve(*S, assume,objectives,opt_pre,found_optimal,d->optimization_callback,d->optimization_callback_data);
+	//a stop request applies to exactly one solve call (the one running, or if none is running, the next one)
+	S->clearStop();
 	d->last_solution_optimal=found_optimal;
 	if(r==l_False){
 		d->has_conflict_clause_from_last_solution=true;
@@ -800,6 +937,16 @@ int solveAssumptionsLimited(Monosat::SimpSolver * S,int * assumptions, int n_ass
 bool solveAssumptions(Monosat::SimpSolver * S,int * assumptions, int n_assumptions){
 	return _solve(S,assumptions,n_assumptions);
 }
+void setOptimizationCallback(Monosat::SimpSolver * S, OptimizationCallback callback, void * data){
+	MonosatData * d = (MonosatData*) S->_external_data;
+	d->optimization_callback=callback;
+	d->optimization_callback_data=data;
+}
+
+void interruptSolver(Monosat::SimpSolver * S){
+	S->requestStop();
+}
+
 bool lastSolutionWasOptimal(Monosat::SimpSolver * S){
 	MonosatData * d = (MonosatData*) S->_external_data;
 	if(d){
@@ -903,7 +1050,8 @@ int true_lit(Monosat::SimpSolver * S){
 	return toInt(l);
 }
 bool addClause(Monosat::SimpSolver * S,int * lits, int n_lits){
-	static vec<Lit> clause;
+	MonosatData * d = (MonosatData*) S->_external_data;
+	vec<Lit> & clause = d->tmp_lits;
 	clause.clear();
 	for (int i = 0;i<n_lits;i++){
 		clause.push(toLit(lits[i]));
@@ -945,7 +1093,8 @@ int newBitvector_const(Monosat::SimpSolver * S, Monosat::BVTheorySolver<int64_t>
 
 
 int newBitvector(Monosat::SimpSolver * S, Monosat::BVTheorySolver<int64_t> * bv, int * bits, int n_bits){
-	static vec<Var> lits;
+	MonosatData * d = (MonosatData*) S->_external_data;
+	vec<Var> & lits = d->tmp_vars;
 	lits.clear();
 	for (int i = 0;i<n_bits;i++){
 		lits.push(Var(bits[i]));
@@ -1216,7 +1365,7 @@ void assertPB(Monosat::SimpSolver * S, int _rhs, int n_args, int * literals, int
 			d->pbsolver = new PB::PbSolver(*S);
 		}
 
-		static vec<Lit> lits;
+		vec<Lit> & lits = d->tmp_lits;
 		lits.clear();
 		for (int i = 0; i < n_args; i++) {
 			Lit l = toLit(literals[i]);
@@ -1224,7 +1373,7 @@ void assertPB(Monosat::SimpSolver * S, int _rhs, int n_args, int * literals, int
 			write_out(S,"%d ", dimacs(l));
 		}
 		write_out(S,"%d ", n_args);
-		static vec<PB::Int> coefs;
+		vec<PB::Int> & coefs = d->tmp_coefs;
 		coefs.clear();
 		for (int i = 0; i < n_args; i++) {
 			coefs.push(PB::Int(coefficients[i]));
@@ -1265,6 +1414,24 @@ int newEdge(Monosat::SimpSolver * S, Monosat::GraphTheorySolver<int64_t> *G,int
 	G->newEdge( from,  to, v,  weight );
 	return toInt(l);
 }
+int newNodes(Monosat::SimpSolver * S,Monosat::GraphTheorySolver<int64_t> *G, int n){
+	return G->newNodes(n);
+}
+void newEdges(Monosat::SimpSolver * S, Monosat::GraphTheorySolver<int64_t> *G,int * from,int * to, int64_t * weights, int n, int * out_lits){
+	if(n<=0)
+		return;
+	S->reserveVars(n);
+	std::vector<Var> vars(n);
+	for(int i = 0;i<n;i++){
+		Var v = newVar(S);
+		Lit l =mkLit(v);
+		vars[i]=v;
+		write_out(S,"edge %d %d %d %d %ld\n",G->getGraphID(),from[i],to[i], dimacs(l),weights ? weights[i] : (int64_t)1);
+		if(out_lits)
+			out_lits[i]=toInt(l);
+	}
+	G->newEdges(from,to,weights,vars.data(),n);
+}
 int newEdge_double(Monosat::SimpSolver * S, Monosat::GraphTheorySolver<double> *G,int from,int  to,  double weight){
 	Var v = newVar(S);
 	Lit l =mkLit(v);
@@ -1404,7 +1571,8 @@ int acyclic_directed(Monosat::SimpSolver * S,Monosat::GraphTheorySolver<int64_t>
 
 
 void newEdgeSet(Monosat::SimpSolver * S,Monosat::GraphTheorySolver<int64_t> *G,int * edges, int n_edges, bool enforceEdgeAssignment){
-	static vec<int> edge_set;
+	MonosatData * d = (MonosatData*) S->_external_data;
+	vec<int> & edge_set = d->tmp_ints;
 	edge_set.clear();
 	write_out(S,"edge_set %d %d", G->getGraphID(), n_edges);
 	for (int i = 0;i<n_edges;i++){
@@ -1427,7 +1595,7 @@ void newEdgeSet(Monosat::SimpSolver * S,Monosat::GraphTheorySolver<int64_t> *G,i
 	}
 	write_out(S,"\n");
 
-	static vec<Lit> edge_lits;
+	vec<Lit> & edge_lits = d->tmp_lits;
 	edge_lits.clear();
 	for(int edgeID:edge_set){
 		edge_lits.push(mkLit(G->toSolver(G->getEdgeVar(edgeID))));
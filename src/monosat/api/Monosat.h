@@ -74,8 +74,11 @@ typedef int64_t Weight;
 #endif
 
   void deleteSolver (SolverPtr S);
-  //If set, dump constraints to this file (as they are asserted in the solver)
+  //If set, dump constraints to this file (as they are asserted in the solver).
+  //If the file name ends in '.gnfb', the constraints are written in binary GNF format, which is only complete after the next solve call.
+  //With the '-async-output' option, output is buffered and written on a background thread; it is guaranteed to be on disk at each solve call.
   void setOutputFile(SolverPtr S,char * output);
+  //Read constraints from a GNF file (plain, gzipped, or binary)
   void readGNF(SolverPtr S, const char  * filename);
 
   bool solve(SolverPtr S);
@@ -103,6 +106,16 @@ typedef int64_t Weight;
 
   bool lastSolutionWasOptimal(SolverPtr S);
 
+  //Anytime optimization: calls callback(data, n_objectives, values, bounds) each time a solve call finds a model that improves
+  //on the best model found so far for the optimization objectives. values[i] is the value of objective i in that model,
+  //and bounds[i] is the best bound proven so far for it (a lower bound when minimizing, an upper bound when maximizing).
+  //The model can be read with the getModel functions from within the callback. Set callback to null to disable.
+  void setOptimizationCallback(SolverPtr S, void (*callback)(void * data, int n_objectives, const int64_t * values, const int64_t * bounds), void * data);
+  //Thread safe: stop the running solve call (or, if none is running, the next one). If a model was already found
+  //during optimization, the solve call returns the best model found so far, and lastSolutionWasOptimal() returns false;
+  //otherwise solveLimited returns 2.
+  void interruptSolver(SolverPtr S);
+
   //If the last solution was unsat, then this get the 'conflict clause' produced by the solver (a subset of the assumptions which are sufficient to cause the instance to be UNSAT).
   //Fills the given pointer with the first max_store_size literals of the conflict clause, and returns the number of literals in the conflict clause. Set store_clause to null and max_store_size to 0 to find the size of the conflict clause
   //Returns -1 if the solver has no conflict clause from the most recent solve() call (because that call was not UNSAT)
@@ -204,6 +217,11 @@ void bv_unary(SolverPtr S, BVTheoryPtr bv, int * args, int n_args, int resultID)
   int newEdge(SolverPtr S, GraphTheorySolver_long G,int from,int  to,  Weight weight);
   int newEdge_double(SolverPtr S, GraphTheorySolver_double G,int from,int  to,  double weight);
   int newEdge_bv(SolverPtr S, GraphTheorySolver_long G,int from,int  to, int bvID);
+  //Create n nodes at once, returning the index of the first one (the new nodes are numbered consecutively)
+  int newNodes(SolverPtr S,GraphTheorySolver_long G, int n);
+  //Create n edges at once, from from[i] to to[i] with weight weights[i] (or 1, if weights is NULL).
+  //If out_lits is non-NULL, the literal of each edge is stored in out_lits[i].
+  void newEdges(SolverPtr S, GraphTheorySolver_long G,int * from,int * to, Weight * weights, int n, int * out_lits);
   int reaches(SolverPtr S,GraphTheorySolver_long G,int from, int to);
   int shortestPathUnweighted_lt_const(SolverPtr S,GraphTheorySolver_long G,int from, int to, int steps);
   int shortestPathUnweighted_leq_const(SolverPtr S,GraphTheorySolver_long G,int from, int to, int steps);
@@ -3,6 +3,7 @@ package synoptic.algorithms;
 import java.nio.ByteBuffer;
 import java.nio.ByteOrder;
 import java.nio.IntBuffer;
+import java.nio.LongBuffer;
 import java.util.ArrayList;
 import java.util.List;
 
@@ -563,6 +564,45 @@ public class Monosat {
 				from, to, weight));
 	}
 
+	/**
+	 * Create n nodes at once, returning the index of the first one (the new
+	 * nodes are numbered consecutively).
+	 */
+	public int newNodes(int graphID, int n) {
+		return MonosatLibrary.newNodes(solver, graphs.get(graphID), n);
+	}
+
+	/**
+	 * Create one edge from from[i] to to[i] for each i, with weight
+	 * weights[i] (or 1, if weights is null), returning the edge literals.
+	 */
+	public int[] newEdges(int graphID, int[] from, int[] to, long[] weights) {
+		int n = from.length;
+		assert (to.length == n);
+		IntBuffer from_buf = ByteBuffer.allocateDirect(n * 4)
+				.order(ByteOrder.nativeOrder()).asIntBuffer();
+		from_buf.put(from);
+		IntBuffer to_buf = ByteBuffer.allocateDirect(n * 4)
+				.order(ByteOrder.nativeOrder()).asIntBuffer();
+		to_buf.put(to);
+		LongBuffer weight_buf = null;
+		if (weights != null) {
+			assert (weights.length == n);
+			weight_buf = ByteBuffer.allocateDirect(n * 8)
+					.order(ByteOrder.nativeOrder()).asLongBuffer();
+			weight_buf.put(weights);
+		}
+		IntBuffer lit_buf = ByteBuffer.allocateDirect(n * 4)
+				.order(ByteOrder.nativeOrder()).asIntBuffer();
+		MonosatLibrary.newEdges(solver, graphs.get(graphID), from_buf, to_buf,
+				weight_buf, n, lit_buf);
+		int[] lits = new int[n];
+		for (int i = 0; i < n; i++) {
+			lits[i] = litToInt(lit_buf.get(i));
+		}
+		return lits;
+	}
+
 	public int reaches(int graphID, int from, int to) {
 		return litToInt(MonosatLibrary.reaches(solver, graphs.get(graphID),
 				from, to));
@@ -131,6 +131,19 @@ class Graph():
 
         return n
     
+    #Add n nodes at once, returning the list of the new nodes.
+    def addNodes(self, n, names=None):
+        if n<=0:
+            return []
+        first = self._monosat.newNodes(self.graph, n)
+        self.nodes=first+n
+        for i in range(n):
+            self.out_edges.append([])
+            self.in_edges.append([])
+            node = first+i
+            self.names[node] = str(names[i]) if names is not None else str(node)
+        return list(range(first, first+n))
+
     def getSymbol(self,node):
         return self.names[node]
     
@@ -225,6 +238,32 @@ class Graph():
         self.edgemap[e[2].getLit()] =e
         return e[2]
     
+    #Add many edges at once. Edges is a list of (v,w) or (v,w,weight) tuples, with constant (int) weights.
+    #Returns the list of edge variables.
+    def addEdges(self,edges):
+        assert(self.graph_type==Graph.GraphType.int)
+        if len(edges)==0:
+            return []
+        self.has_any_non_bv_edges=True
+        assert(not self.has_any_bv_edges)
+        froms = [e[0] for e in edges]
+        tos = [e[1] for e in edges]
+        weights = [e[2] if len(e)>2 else 1 for e in edges]
+        max_node = max(max(froms),max(tos))
+        if max_node>=self.numNodes():
+            self.addNodes(max_node+1-self.numNodes())
+        lits = self._monosat.newEdges(self.graph,froms,tos,weights)
+        vars=[]
+        for i,l in enumerate(lits):
+            e=(froms[i],tos[i],Var(l),weights[i])
+            self.alledges.append(e)
+            self.out_edges[e[0]].append(e)
+            self.in_edges[e[1]].append(e)
+            self.edgemap[e[2].getLit()] =e
+            vars.append(e[2])
+        self.numedges=self.numedges+len(lits)
+        return vars
+
     def addUndirectedEdge(self,v,w, weight=1):
         while(v>=self.numNodes() or w>=self.numNodes()):
             self.addNode()
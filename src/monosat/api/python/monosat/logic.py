@@ -113,12 +113,24 @@ class Var:
             return o;
         if(o.isConstTrue()):
             return self;
-        
+
+        _checkLits((self,o))
+        a=self.getLit()
+        b=o.getLit()
+        if a==b:
+            return self
+        elif a==_monosat.Not(b):
+            return false()
+        gates=_monosat.getSolver().and_gates
+        key=(a,b) if a<b else (b,a)
+        if key in gates:
+            return Var(gates[key])
+
         v=Var()
-        _checkLits((self,o,v))
         _monosat.addTertiaryClause(v.getLit(),_monosat.Not(self.getLit()),_monosat.Not(o.getLit()))
         _monosat.addBinaryClause(_monosat.Not(v.getLit()),self.getLit())
         _monosat.addBinaryClause(_monosat.Not(v.getLit()),o.getLit())
+        gates[key]=v.getLit()
         return v
         #return Var(_monosat.addAnd( self.getLit(),o.getLit()))
      
@@ -131,12 +143,26 @@ class Var:
             return o;
         if(o.isConstFalse()):
             return self;
+
+        _checkLits((self,o))
+        a=self.getLit()
+        b=o.getLit()
+        if a==b:
+            return self
+        elif a==_monosat.Not(b):
+            return true()
+        #a | b is stored as the negation of the gate ~a & ~b
+        gates=_monosat.getSolver().and_gates
+        na=_monosat.Not(a)
+        nb=_monosat.Not(b)
+        key=(na,nb) if na<nb else (nb,na)
+        if key in gates:
+            return Var(_monosat.Not(gates[key]))
         v=Var()
-        _checkLits((self,o,v))
         _monosat.addTertiaryClause(_monosat.Not( v.getLit()),self.getLit(),o.getLit())
         _monosat.addBinaryClause(v.getLit(),_monosat.Not(self.getLit()))
         _monosat.addBinaryClause(v.getLit(),_monosat.Not(o.getLit()))
-    
+        gates[key]=_monosat.Not(v.getLit())
         return v
         #return Var()
         #return Var(_monosat.Not( _monosat.addAnd(  _monosat.Not( self.getLit()),_monosat.Not(o.getLit()))))
@@ -198,8 +224,25 @@ class Var:
         if(o.isConstFalse()):
             return self;
 
+        _checkLits((self,o))
+        a=self.getLit()
+        b=o.getLit()
+        if a==b:
+            return false()
+        elif a==_monosat.Not(b):
+            return true()
+        #Xor gates are stored over positive literals; the output is negated if exactly one input was negative
+        gates=_monosat.getSolver().xor_gates
+        parity=(a&1)!=(b&1)
+        pa=a&~1
+        pb=b&~1
+        key=(pa,pb) if pa<pb else (pb,pa)
+        if key in gates:
+            out=gates[key]
+            return Var(_monosat.Not(out) if parity else out)
+
         v = Var()
-        _checkLits((self,o,v))
+        gates[key]=_monosat.Not(v.getLit()) if parity else v.getLit()
         #If both inputs 0, output must be 0.
         _monosat.addTertiaryClause(_monosat.Not( v.getLit()),self.getLit(),o.getLit())
 
@@ -50,6 +50,7 @@ c_int_p = POINTER(c_int)
 c_long_p = POINTER(c_long)
 
 c_solver_p = c_void_p
+c_optimization_callback = CFUNCTYPE(None, c_void_p, c_int, POINTER(c_int64), POINTER(c_int64))
 c_graph_p = c_void_p
 c_bv_p = c_void_p
 c_fsm_theory_p = c_void_p
@@ -101,6 +102,9 @@ class Solver():
         self.graphs = []
         self.graph_ids=dict()
         self._true = None
+        #structural hashing of the gates built by logic.py: (sorted) input literals -> output literal
+        self.and_gates=dict()
+        self.xor_gates=dict()
       
     def delete(self):        
         Monosat().monosat_c.deleteSolver(self._ptr)
@@ -130,6 +134,8 @@ class Monosat(metaclass=Singleton):
         self.monosat_c.deleteSolver.argtypes=[c_solver_p]
         
         self.monosat_c.readGNF.argtypes=[c_solver_p, c_char_p]
+
+        self.monosat_c.setOutputFile.argtypes=[c_solver_p, c_char_p]
         
         self.monosat_c.solve.argtypes=[c_solver_p]
         self.monosat_c.solve.restype=c_bool
@@ -147,6 +153,9 @@ class Monosat(metaclass=Singleton):
         self.monosat_c.lastSolutionWasOptimal.argtypes=[c_solver_p]
         self.monosat_c.lastSolutionWasOptimal.restype=c_bool
 
+        self.monosat_c.setOptimizationCallback.argtypes=[c_solver_p, c_optimization_callback, c_void_p]
+        self.monosat_c.interruptSolver.argtypes=[c_solver_p]
+
         self.monosat_c.getConflictClause.argtypes=[c_solver_p, c_int_p,c_int]
         self.monosat_c.getConflictClause.restype=c_int 
 
@@ -290,6 +299,12 @@ class Monosat(metaclass=Singleton):
        
         self.monosat_c.newEdge_bv.argtypes=[c_solver_p,c_graph_p, c_int, c_int, c_bvID]
         self.monosat_c.newEdge_bv.restype=c_literal
+
+        self.monosat_c.newNodes.argtypes=[c_solver_p,c_graph_p, c_int]
+        self.monosat_c.newNodes.restype=c_int
+
+        self.monosat_c.newEdges.argtypes=[c_solver_p,c_graph_p, c_int_p, c_int_p, c_long_p, c_int, c_literal_p]
+        self.monosat_c.newEdges.restype=None
        
         self.monosat_c.reaches.argtypes=[c_solver_p,c_graph_p, c_int, c_int]
         self.monosat_c.reaches.restype=c_literal
@@ -515,6 +530,23 @@ class Monosat(metaclass=Singleton):
     def lastSolutionWasOptimal(self):
         return self.monosat_c.lastSolutionWasOptimal(self.solver._ptr)
 
+    def setOptimizationCallback(self, callback):
+        #callback(values, bounds) is called with the objective values of each improved model found during optimization,
+        #and the best bound proven so far for each objective. Pass None to disable.
+        if callback is None:
+            self.solver._optimization_callback=None
+            self.monosat_c.setOptimizationCallback(self.solver._ptr,c_optimization_callback(0),None)
+            return
+        def _callback(data, n_objectives, values, bounds):
+            callback([values[i] for i in range(n_objectives)],[bounds[i] for i in range(n_objectives)])
+        #keep a reference to the ctypes function for as long as the solver may call it
+        self.solver._optimization_callback=c_optimization_callback(_callback)
+        self.monosat_c.setOptimizationCallback(self.solver._ptr,self.solver._optimization_callback,None)
+
+    def interruptSolver(self):
+        #Thread safe: stops the running (or next) solve call, keeping the best model found so far during optimization.
+        self.monosat_c.interruptSolver(self.solver._ptr)
+
     def getConflictClause(self):
         conflict_size =  self.monosat_c.getConflictClause(self.solver._ptr,null_ptr,0)
         if conflict_size<0:
@@ -1074,6 +1106,29 @@ class Monosat(metaclass=Singleton):
             self._echoOutput("edge " + str(self.getGID(graph)) + " " + str(u) + " " + str(v) + " " +  str(dimacs(l)) + " " + str((weight))  + "\n")
         return l
     
+    def newNodes(self, graph, n):
+        self.backtrack()
+        return self.monosat_c.newNodes(self.solver._ptr,graph,c_int(n))
+
+    #Create many edges with a single call, returning the list of their literals.
+    #Weights may be None, in which case all of the edges have weight 1.
+    def newEdges(self, graph, froms, tos, weights=None):
+        self.backtrack()
+        n = len(froms)
+        assert(len(tos)==n)
+        if n==0:
+            return []
+        from_array = (c_int * n)(*froms)
+        to_array = (c_int * n)(*tos)
+        weight_array = (c_long * n)(*weights) if weights is not None else None
+        lits = (c_int * n)()
+        self.monosat_c.newEdges(self.solver._ptr,graph,from_array,to_array,weight_array,c_int(n),lits)
+        ret = list(lits)
+        if self.solver.output:
+            gid = str(self.getGID(graph))
+            self._echoOutput("".join("edge " + gid + " " + str(froms[i]) + " " + str(tos[i]) + " " +  str(dimacs(ret[i])) + " " + str(weights[i] if weights is not None else 1)  + "\n" for i in range(n)))
+        return ret
+
     def newEdge_double(self, graph, u,v, weight):
         self.backtrack()
         l = self.monosat_c.newEdge_double(self.solver._ptr,graph,c_int(u),c_int(v),c_double(weight))
@@ -28,6 +28,8 @@
 
 #include "monosat/core/SolverTypes.h"
 #include "monosat/mtl/Map.h"
+#include "monosat/mtl/Sort.h"
+#include "monosat/mtl/WideInt.h"
 
 #include "monosat/bv/BVTheory.h"
 #include "monosat/utils/System.h"
@@ -78,6 +80,61 @@ inline Comparison operator -(Comparison p) {
 			return Comparison::lt;
 	}
 }
+//Bit-level access to the values of bitvectors, for each weight type the bitvector theory may be instantiated with.
+template<typename Weight>
+struct BVWeight {
+	//2^i
+	static inline Weight bit(int i) {
+		return ((Weight) 1) << i;
+	}
+	//the largest value of a bitvector of the given width, 2^width - 1
+	static inline Weight maxValue(int width) {
+		if (width >= (int) (sizeof(Weight) * 8) - 1)
+			return std::numeric_limits<Weight>::max();
+		return bit(width) - 1;
+	}
+	static inline bool test(const Weight & w, int i) {
+		return (w >> i) & 1;
+	}
+	static inline void set(Weight & w, int i) {
+		w |= bit(i);
+	}
+};
+//Wide weights avoid building a temporary for each bit.
+template<int Limbs>
+struct BVWeight<WideInt<Limbs>> {
+	static inline WideInt<Limbs> bit(int i) {
+		return WideInt<Limbs>::bit(i);
+	}
+	static inline WideInt<Limbs> maxValue(int width) {
+		return WideInt<Limbs>::mask(width);
+	}
+	static inline bool test(const WideInt<Limbs> & w, int i) {
+		return w.testBit(i);
+	}
+	static inline void set(WideInt<Limbs> & w, int i) {
+		w.setBit(i);
+	}
+};
+template<>
+struct BVWeight<double> {
+	static inline double bit(int i) {
+		return std::ldexp(1.0, i);
+	}
+	static inline double maxValue(int width) {
+		return bit(width) - 1;
+	}
+};
+template<>
+struct BVWeight<mpq_class> {
+	static inline mpq_class bit(int i) {
+		return mpq_class(1) << i;
+	}
+	static inline mpq_class maxValue(int width) {
+		return bit(width) - 1;
+	}
+};
+
 inline std::ostream& operator<<(std::ostream &out, const Comparison &p) {
 	switch (p){
 		case Comparison::lt:
@@ -301,11 +358,11 @@ public:
 				}
 
 				under =0;
-				over=(1L<<bv.size())-1;
+				over=BVWeight<Weight>::maxValue(bv.size());
 				new_change=false;
 				//for(int i = 0;i<bv.size();i++){
 				for(int i = bv.size()-1;i>=0;i--){
-					Weight bit = 1<<i;
+					Weight bit = BVWeight<Weight>::bit(i);
 					lbool val = value(bv[i]);
 					Lit l = bv[i];
 					if(val==l_True){
@@ -316,7 +373,7 @@ public:
 								//propagationtime += startconftime - startproptime;
 								//this is a conflict
 								for(int j = bv.size()-1;j>=i;j--){
-									Weight bit = 1<<j;
+									Weight bit = BVWeight<Weight>::bit(j);
 									lbool val = value(bv[j]);
 									if(val==l_True){
 										conflict.push(toSolver(~bv[j]));
@@ -341,7 +398,7 @@ public:
 								//this is a conflict. Either this bit, or any previously assigned false bit, must be true, or the underapprox must be larger than it currently is.
 								//is this really the best way to handle this conflict?
 								for(int j = bv.size()-1;j>=i;j--){
-									Weight bit = 1<<j;
+									Weight bit = BVWeight<Weight>::bit(j);
 									lbool val = value(bv[j]);
 									if(val==l_False){
 										conflict.push(toSolver(bv[j]));
@@ -390,12 +447,12 @@ public:
 			for(int i = 0;i<bv.size();i++){
 				lbool val = value(bv[i]);
 				if(val==l_True){
-					Weight bit = 1<<i;
+					Weight bit = BVWeight<Weight>::bit(i);
 					under+=bit;
 					over+=bit;
 				}else if (val==l_False){
 				}else{
-					Weight bit = 1<<i;
+					Weight bit = BVWeight<Weight>::bit(i);
 					over+=bit;
 				}
 			}
@@ -413,20 +470,20 @@ public:
 			vec<Lit> & bv = theory.bitvectors[bvID];
 			for(int i = 0;i<bv.size();i++){
 				if(var(bv[i])==ignore_bv){
-					Weight bit = 1<<i;
+					Weight bit = BVWeight<Weight>::bit(i);
 					over+=bit;
 					continue;
 				}
 				lbool val = value(bv[i]);
 				if(val==l_True){
-					Weight bit = 1<<i;
+					Weight bit = BVWeight<Weight>::bit(i);
 					under+=bit;
 					over+=bit;
 
 				}else if (val==l_False){
 
 				}else{
-					Weight bit = 1<<i;
+					Weight bit = BVWeight<Weight>::bit(i);
 					over+=bit;
 				}
 			}
@@ -456,7 +513,7 @@ public:
 			Weight overApprox = over_approx[bvID];
 
 
-			assert(under_approx>=0); assert(overApprox>=0);
+			assert(underApprox>=0); assert(overApprox>=0);
 			vec<Lit> & bv = theory.bitvectors[bvID];
 
 			int bitpos=-1;
@@ -472,10 +529,10 @@ public:
 
 			assert(bitpos>=0);
 			Weight under = 0;
-			Weight over=(1L<<bv.size())-1;
+			Weight over=BVWeight<Weight>::maxValue(bv.size());
 
 			for(int i = bv.size()-1;i>=0;i--){
-				Weight bit = 1<<i;
+				Weight bit = BVWeight<Weight>::bit(i);
 				lbool val = value(bv[i]);
 				Lit l = bv[i];
 				if(val==l_True){
@@ -491,7 +548,7 @@ public:
 						//this is a conflict. Either this bit, or any previously assigned false bit, must be true, or the underapprox must be larger than it currently is.
 						//is this really the best way to handle this conflict?
 						for(int j = bv.size()-1;j>=i;j--){
-							Weight bit = 1<<j;
+							Weight bit = BVWeight<Weight>::bit(j);
 							lbool val = value(bv[j]);
 							if(val==l_False){
 								reason.push(toSolver(bv[j]));
@@ -505,7 +562,7 @@ public:
 						assert(bitpos==i);
 						//this is a conflict
 						for(int j = bv.size()-1;j>=i;j--){
-							Weight bit = 1<<j;
+							Weight bit = BVWeight<Weight>::bit(j);
 							lbool val = value(bv[j]);
 							if(val==l_True){
 								reason.push(toSolver(~bv[j]));
@@ -528,7 +585,7 @@ public:
 				for(int i =0;i<bv.size();i++){
 					Lit bl = bv[i];
 					if(value(bl)==l_False ){
-						Weight bit = 1<<i;
+						Weight bit = BVWeight<Weight>::bit(i);
 						if(theory.comp(op,over+bit,to)&& theory.level(var(bl))>0){
 							//then we can skip this bit, because we would still have had a conflict even if it was assigned true.
 							over+=bit;
@@ -545,7 +602,7 @@ public:
 					lbool val = value(bl);
 
 					if(value(bl)==l_True){
-						Weight bit = 1<<i;
+						Weight bit = BVWeight<Weight>::bit(i);
 						if(theory.comp(op,under-bit,to)  && theory.level(var(bl))>0){
 							//then we can skip this bit, because we would still have had a conflict even if it was assigned false.
 							under-=bit;
@@ -569,13 +626,13 @@ public:
 			for(int i = 0;i<bv.size();i++){
 				lbool val = value(bv[i]);
 				if(val==l_True){
-					Weight bit = 1<<i;
+					Weight bit = BVWeight<Weight>::bit(i);
 					under+=bit;
 					over+=bit;
 				}else if (val==l_False){
 
 				}else{
-					Weight bit = 1<<i;
+					Weight bit = BVWeight<Weight>::bit(i);
 					over+=bit;
 				}
 			}
@@ -938,10 +995,8 @@ public:
 				Var v= var(l);
 				if(alter_trail){
 					//theory.trail.push( { true, !sign(l),getID(), v });
-					theory.bv_needs_propagation[bvID]=true;
-
-
-					addAlteredBV(bvID);
+					theory.pending_compares[bvID].push(getID());
+					theory.addAlteredBV(bvID,false);
 				}
 			}
 			void backtrack(Assignment & e, bool rewind)override{
@@ -951,7 +1006,7 @@ public:
 							theory.alteredBV[bvID]=true;
 							theory.altered_bvs.push(bvID);
 						}
-						theory.bv_needs_propagation[bvID]=true;
+						theory.compares_synced[bvID]=false;
 						theory.requiresPropagation=true;
 						theory.S->needsPropagation(theory.getTheoryIndex());
 					}
@@ -1673,13 +1728,13 @@ public:
 			for(int i = 0;i<bv_compare.size();i++){
 				lbool val = value(bv_compare[i]);
 				if(val==l_True){
-					Weight bit = 1<<i;
+					Weight bit = BVWeight<Weight>::bit(i);
 					under_compare+=bit;
 					over_compare+=bit;
 				}else if (val==l_False){
 
 				}else{
-					Weight bit = 1<<i;
+					Weight bit = BVWeight<Weight>::bit(i);
 					over_compare+=bit;
 				}
 			}
@@ -2814,7 +2869,7 @@ public:
 			Weight over_add = over_approx[aID] +  over_approx[bID];
 
 			int width = theory.bitvectors[bvID].size();
-			Weight max_val = ((1L)<<width)-1;
+			Weight max_val = BVWeight<Weight>::maxValue(width);
 			if(under_add>max_val){
 				under_add=max_val;
 			}
@@ -2892,7 +2947,7 @@ public:
 			int aID=arg1->bvID;
 			int bID=arg2->bvID;
 			int width = theory.bitvectors[bvID].size();
-			Weight max_val = (1L<<width)-1;
+			Weight max_val = BVWeight<Weight>::maxValue(width);
 			//assert(aID<bvID);
 			//assert(bID<bvID);
 			Weight underadd = under_approx[aID] +  under_approx[bID];
@@ -3056,7 +3111,7 @@ public:
 			Weight over_add = over_approx[sumID] -  under_approx[other_argID];
 
 			int width = theory.bitvectors[bvID].size();
-			Weight max_val = ((1L)<<width)-1;
+			Weight max_val = BVWeight<Weight>::maxValue(width);
 			if(under_add>max_val){
 				under_add=max_val;
 			}
@@ -3132,7 +3187,7 @@ public:
 			int other_argID=otherOp->bvID;
 			int sumID=resultOp->bvID;
 			int width = theory.bitvectors[sumID].size();
-			Weight max_val = (1L<<width)-1;
+			Weight max_val = BVWeight<Weight>::maxValue(width);
 			//assert(aID<bvID);
 			//assert(bID<bvID);
 			Weight underadd = under_approx[bvID] +  under_approx[other_argID];
@@ -3761,7 +3816,7 @@ public:
 			Weight &underApprox = under_approx[bvID];
 			Weight &overApprox = over_approx[bvID];
             int width = theory.bitvectors[bvID].size();
-            Weight max_val = ((1L) << width) - 1;
+            Weight max_val = BVWeight<Weight>::maxValue(width);
             if(bvID==7){
                 int a =1;
             }
@@ -3874,7 +3929,7 @@ public:
 			Weight over_add = over_approx[aID] * over_approx[bID];
 
 			int width = theory.bitvectors[bvID].size();
-			Weight max_val = ((1L) << width) - 1;
+			Weight max_val = BVWeight<Weight>::maxValue(width);
 			if (under_add > max_val) {
 				under_add = max_val;
 			}
@@ -3908,7 +3963,7 @@ public:
 				Weight over_bid = over_approx[bID];
 				Weight over_aid = over_approx[aID];
                 int width = theory.bitvectors[bvID].size();
-                Weight max_val = ((1L) << width) - 1;
+                Weight max_val = BVWeight<Weight>::maxValue(width);
                 addAnalysis(Comparison::leq, aID,safeDivide( over_approx[bvID] , over_bid,max_val));
                 addAnalysis(Comparison::leq, bID, safeDivide(over_approx[bvID] , over_aid,max_val));
 			} else {
@@ -3943,7 +3998,7 @@ public:
 			int bID = arg2->bvID;
 
 			int width = theory.bitvectors[bvID].size();
-			Weight max_val = (1L << width) - 1;
+			Weight max_val = BVWeight<Weight>::maxValue(width);
 
 			Weight underadd = under_approx[aID] *under_approx[bID];
 			Weight overadd = over_approx[aID]  * over_approx[bID];
@@ -4021,7 +4076,7 @@ public:
 			assert(other_argID >= 0);
 			assert(sumID >= 0);
             int width = theory.bitvectors[bvID].size();
-            Weight max_val = ((1L) << width) - 1;
+            Weight max_val = BVWeight<Weight>::maxValue(width);
             Weight under = safeDivide(under_approx[sumID] , over_approx[other_argID],0);
             Weight over = safeDivide(over_approx[sumID] , under_approx[other_argID],max_val);
 			clip_under(under, bvID);
@@ -4088,7 +4143,7 @@ public:
 			int other_argID = otherOp->bvID;
 			int sumID = resultOp->bvID;
             int width = theory.bitvectors[bvID].size();
-            Weight max_val = ((1L) << width) - 1;
+            Weight max_val = BVWeight<Weight>::maxValue(width);
 			assert(other_argID >= 0);
 			assert(sumID >= 0);
             Weight under = safeDivide(under_approx[sumID] , over_approx[other_argID],0);
@@ -4123,7 +4178,7 @@ public:
 			Weight over_cur = over_approx[bvID];
 			Weight under_cur = under_approx[bvID];
 			int width = theory.bitvectors[bvID].size();
-			Weight max_val = ((1L) << width) - 1;
+			Weight max_val = BVWeight<Weight>::maxValue(width);
             Weight under_add = safeDivide(under_approx[sumID] , over_approx[other_argID],0);
             Weight over_add = safeDivide(over_approx[sumID] , under_approx[other_argID],max_val);
 
@@ -4183,7 +4238,7 @@ public:
 			int other_argID = otherOp->bvID;
 			int sumID = resultOp->bvID;
             int width = theory.bitvectors[bvID].size();
-            Weight max_val = ((1L) << width) - 1;
+            Weight max_val = BVWeight<Weight>::maxValue(width);
             Weight under_add = safeDivide(under_approx[sumID], over_approx[other_argID],0);
             Weight over_add = safeDivide(over_approx[sumID] , under_approx[other_argID],max_val);
 
@@ -4201,7 +4256,7 @@ public:
 			int other_argID = otherOp->bvID;
 			int sumID = resultOp->bvID;
 			int width = theory.bitvectors[sumID].size();
-			Weight max_val = (1L << width) - 1;
+			Weight max_val = BVWeight<Weight>::maxValue(width);
 
 
 			//assert(aID<bvID);
@@ -4262,7 +4317,7 @@ public:
 				Weight & overApprox = over_approx[bvID];
 
 				int width =  theory.bitvectors[bvID].size();
-				Weight max_val = ((1L)<<width)-1;
+				Weight max_val = BVWeight<Weight>::maxValue(width);
 				Weight & otherUnder = under_approx[ argOp->bvID];
 				Weight & otherOver = over_approx[ argOp->bvID];
 
@@ -4326,7 +4381,7 @@ public:
 						int a=1;
 					}
 					int width =  theory.bitvectors[bvID].size();
-					Weight max_val = ((1L)<<width)-1;
+					Weight max_val = BVWeight<Weight>::maxValue(width);
 					Weight & otherUnder = under_approx[ argOp->bvID];
 					Weight & otherOver = over_approx[ argOp->bvID];
 
@@ -4355,7 +4410,7 @@ public:
 				void analyzeReason(bool compare_over,Comparison op, Weight  to,  vec<Lit> & conflict){
 					importTheory(theory);
 					int width =  theory.bitvectors[bvID].size();
-					Weight max_val = ((1L)<<width)-1;
+					Weight max_val = BVWeight<Weight>::maxValue(width);
 					Weight val = max_val-to;
 					theory.analyzeValueReason(~op,argOp->getBV(),val,conflict);
 				}
@@ -4363,7 +4418,7 @@ public:
 				bool checkApproxUpToDate(Weight & under,Weight&over)override{
 					importTheory(theory);
 					int width =  theory.bitvectors[bvID].size();
-					Weight max_val = ((1L)<<width)-1;
+					Weight max_val = BVWeight<Weight>::maxValue(width);
 					Weight & otherUnder = under_approx[ argOp->bvID];
 					Weight & otherOver = over_approx[ argOp->bvID];
 
@@ -4386,7 +4441,7 @@ public:
 				bool checkSolved()override{
 					importTheory(theory);
 					int width =  theory.bitvectors[bvID].size();
-					Weight max_val = ((1L)<<width)-1;
+					Weight max_val = BVWeight<Weight>::maxValue(width);
 					Weight & otherUnder = under_approx[ argOp->bvID];
 					Weight & otherOver = over_approx[ argOp->bvID];
 
@@ -4541,6 +4596,14 @@ public:
 	vec<vec<int>> bvcompares;
 	vec<int> eq_bitvectors;//if a bv has been proven to be equivalent to another, lower index bv, put the lowest such index here.
 	vec<bool> bv_needs_propagation;
+	//If compares_synced[bvID] is true, then every comparison to a constant on bvID that is implied by the bounds
+	//(compares_under[bvID], compares_over[bvID]) has been propagated, and only the comparisons whose thresholds lie
+	//between those bounds and the current approximation (along with any comparisons in pending_compares[bvID], which were
+	//assigned since) need to be visited.
+	vec<bool> compares_synced;
+	vec<Weight> compares_under;
+	vec<Weight> compares_over;
+	vec<vec<int>> pending_compares;
 	vec<bool> comparison_needs_repropagation;
 	vec<int> repropagate_comparisons;
 
@@ -4633,6 +4696,10 @@ public:
 	long stats_propagations = 0;
 	long stats_bv_propagations =0;
 	long stats_bv_skipped_propagations=0;
+	long stats_compares_visited=0;
+	long stats_compares_skipped=0;
+	long stats_bv_ops_skipped=0;
+	long stats_merged_bvs=0;
 	long stats_num_conflicts = 0;
 	long stats_mult_conflicts=0;
 	long stats_bit_conflicts = 0;
@@ -4713,6 +4780,10 @@ public:
 
 		printf("Propagations: %ld (%f s, avg: %f s, %ld skipped), bv updates: %ld (%f s), bv propagations %ld (%ld skipped)\n", stats_propagations, propagationtime,
 				(propagationtime) / ((double) stats_propagations + 1), stats_propagations_skipped,statis_bv_updates,stats_update_time,stats_bv_propagations,stats_bv_skipped_propagations);
+		printf("Comparisons visited: %ld (%ld skipped), operation propagations skipped: %ld\n", stats_compares_visited,stats_compares_skipped,stats_bv_ops_skipped);
+		if(opt_theory_equivalences){
+			printf("Merged bitvectors: %ld\n", stats_merged_bvs);
+		}
 		printf("Decisions: %ld (%f s, avg: %f s)\n", stats_decisions, stats_decision_time,
 				(stats_decision_time) / ((double) stats_decisions + 1));
 		printf("Conflicts: %ld (bits: %ld, additions: %ld, comparisons: %ld, bv comparisons: %ld), %f seconds\n", stats_num_conflicts,stats_bit_conflicts,stats_addition_conflicts,stats_compare_conflicts,stats_bv_compare_conflicts, stats_conflict_time);
@@ -4763,8 +4834,10 @@ public:
 		while(eq_bitvectors[bvID2]!=bvID2){
 			bvID2=eq_bitvectors[bvID2];
 		}
-		if (bvID1<bvID2)
+		if (bvID1<bvID2){
 			makeEquivalent(bvID2,bvID1);
+			return;
+		}
 
 
 		if(bitvectors[bvID1].size() && bitvectors[bvID2].size()){
@@ -4785,6 +4858,11 @@ public:
 			op.move(bvID2);
 			compares[bvID2].push(cID);
 		}
+		if(compares[bvID1].size()){
+			//keep the comparisons sorted by threshold
+			sort(compares[bvID2],CompareLt(*this));
+			compares_synced[bvID2]=false;
+		}
 
 		for(int i = bvcompares[bvID1].size()-1;i>=0;i--){
 			int cID = bvcompares[bvID1][i];
@@ -5249,6 +5327,8 @@ public:
 					over_approx[bvID]=e.previous_over;
 					under_causes[bvID]=e.prev_under_cause;
 					over_causes[bvID]=e.prev_over_cause;
+					//comparisons that were assigned above this level are now unassigned
+					compares_synced[bvID]=false;
 
 					if(hasTheory(bvID))
 						getTheory(bvID)->backtrackBV(bvID);//only enqueue the bitvector in the subtheory _after_ it's approximation has been updated!
@@ -5436,7 +5516,7 @@ public:
 			for(int i = bits.size()-1;i>=0;i--){
 				Lit b = bits[i];
 				if(value(b)==l_Undef){
-					Weight bit = 1L<<i;
+					Weight bit = BVWeight<Weight>::bit(i);
 
 					bool positive=true;
 					if (bit_under+ bit > to ||  bit_under+ bit > over_approx[bvID]){
@@ -5445,7 +5525,7 @@ public:
 					l= positive ? b:~b;
 					break;
 				}else if (value(b)==l_True){
-					Weight bit = 1L<<i;
+					Weight bit = BVWeight<Weight>::bit(i);
 					bit_under+=bit;
 				}else{
 
@@ -5521,6 +5601,74 @@ public:
 			const_true=True();
 
 	}
+
+	//Merge bitvectors whose bits the SAT solver has proven pairwise equivalent, using makeEquivalent, so that their
+	//comparisons are tracked (and propagated) on a single bitvector.
+	//Only bitvectors that are defined by their bits alone, and compared only to constants, are considered.
+	void mergeEquivalentAtoms() override {
+		vec<int> candidates;
+		vec<vec<Lit>> rep_bits;
+		rep_bits.growTo(bitvectors.size());
+		for(int bvID = 0;bvID<bitvectors.size();bvID++){
+			if(!hasBV(bvID) || eq_bitvectors[bvID]!=bvID || bitvectors[bvID].size()==0 || hasTheory(bvID)
+					|| bvcompares[bvID].size() || cause_set[bvID].size())
+				continue;
+			bool only_bits=true;
+			for(int opID:operation_ids[bvID]){
+				if(getOperation(opID).getType()!=OperationType::cause_is_bits){
+					only_bits=false;
+					break;
+				}
+			}
+			if(!only_bits)
+				continue;
+			rep_bits[bvID].clear();
+			for(Lit l:bitvectors[bvID]){
+				rep_bits[bvID].push(S->getEquivalentLit(toSolver(l)));
+			}
+			candidates.push(bvID);
+		}
+		auto lessBits = [&](int a, int b){
+			vec<Lit> & bitsA = rep_bits[a];
+			vec<Lit> & bitsB = rep_bits[b];
+			if(bitsA.size()!=bitsB.size())
+				return bitsA.size()<bitsB.size();
+			for(int i = 0;i<bitsA.size();i++){
+				if(bitsA[i]!=bitsB[i])
+					return bitsA[i]<bitsB[i];
+			}
+			return false;
+		};
+		sort(candidates,[&](int a, int b){
+			if(lessBits(a,b))
+				return true;
+			if(lessBits(b,a))
+				return false;
+			return a<b;
+		});
+		for(int i = 0;i<candidates.size();){
+			int rep = candidates[i++];
+			bool merged=false;
+			while(i<candidates.size() && !lessBits(rep,candidates[i])){
+				makeEquivalent(candidates[i++],rep);
+				stats_merged_bvs++;
+				merged=true;
+			}
+			if(merged){
+				//comparisons of the merged bitvectors to the same constant are equivalent
+				vec<int> & compare = compares[rep];
+				for(int j = 1;j<compare.size();j++){
+					ComparisonOp & prev = (ComparisonOp &) getOperation(compare[j-1]);
+					for(int k = j;k<compare.size() && ((ComparisonOp &) getOperation(compare[k])).w==prev.w;k++){
+						ComparisonOp & cur = (ComparisonOp &) getOperation(compare[k]);
+						if(cur.getOp()==prev.getOp() && cur.l!=prev.l){
+							makeEqual(cur.l,prev.l);
+						}
+					}
+				}
+			}
+		}
+	}
 	void setLiteralOccurs(Lit l, bool occurs) {
 		/*if (isEdgeVar(var(l))) {
 			//don't do anything
@@ -5751,9 +5899,14 @@ public:
 
 		assert_in_range(under_new,bvID);
 		assert_in_range(over_new,bvID);
-		//special handling for comparisons against constants, which are kept in sorted order, allowing some short-circuiting
-		for(int i = compares[bvID].size()-1;i>=0;i--){
-			int cID = compares[bvID][i];
+		//special handling for comparisons against constants, which are kept in sorted order, allowing some short-circuiting:
+		//a comparison can only lower the over approx if its threshold is between the level 0 under approx and the current over approx
+		//(and symmetrically for the under approx), so the comparisons outside of those ranges are skipped.
+		vec<int> & compare = compares[bvID];
+		int over_end = upperBoundWeight(compare,over_new);
+		int over_begin = lowerBoundWeight(compare,under_approx0[bvID]);
+		for(int i = over_end-1;i>=over_begin;i--){
+			int cID = compare[i];
 			if(cID==ignoreCID){
 				continue;
 			}
@@ -5761,7 +5914,10 @@ public:
 			c.updateApprox(ignore_bv, under_new,  over_new,  under_cause_new,  over_cause_new,true);
 		}
 
-		for(int cID:compares[bvID]){
+		int under_begin = lowerBoundWeight(compare,under_new);
+		int under_end = upperBoundWeight(compare,over_approx0[bvID]);
+		for(int i = under_begin;i<under_end;i++){
+			int cID = compare[i];
 			if(cID==ignoreCID){
 				continue;
 			}
@@ -5854,7 +6010,7 @@ public:
 		assert_in_range(over_new,bvID);
 
 		//int width = bitvectors[bvID].size();
-		//Weight max_val = ((1L)<<width)-1;
+		//Weight max_val = BVWeight<Weight>::maxValue(width);
 
 
 		assert_in_range(under_new,bvID);
@@ -6044,7 +6200,7 @@ public:
 			}
 
 			int width = bitvectors[bvID].size();
-			Weight max_val = (1L<<width)-1;
+			Weight max_val = BVWeight<Weight>::maxValue(width);
 			if(under>over_approx0[bvID]){
 				under=over_approx0[bvID];
 			}
@@ -6128,8 +6284,9 @@ public:
 #endif
 		return true;
 	}*/
-	void addAlteredBV( int newBV){
-        bv_needs_propagation[newBV]=true;//is this really required
+	void addAlteredBV( int newBV, bool needs_propagation=true){
+		if(needs_propagation)
+			bv_needs_propagation[newBV]=true;//is this really required
 		if (altered_bvs.size()==0){
 			altered_bvs.push(newBV);
 			alteredBV[newBV]=true;
@@ -6204,7 +6361,9 @@ public:
 			Cause prev_over_cause = over_causes[bvID];
 
 			bool changed = updateApproximations(bvID);//can split this into changedUpper and changedLower...
+			bool run_operations = changed || bv_needs_propagation[bvID];
 			changed |=bv_needs_propagation[bvID];
+			changed |= !compares_synced[bvID] || pending_compares[bvID].size();
 			if(!changed){
 				assert( under_approx[bvID]<= over_approx[bvID]);
 				stats_bv_skipped_propagations++;
@@ -6225,19 +6384,35 @@ public:
 
 
 			//also need to iterate through the additions that this bv is an argument of...
-			for(int opID:operation_ids[bvID]){
-				if(opID==1288){
-					int a=1;
-				}
-				if(!getOperation(opID).propagate(changed,conflict)){
-					return false;
+			//(if the only change was the assignment of comparison atoms, which did not refine the approximation, then the operations have nothing new to propagate)
+			if(run_operations){
+				for(int opID:operation_ids[bvID]){
+					if(!getOperation(opID).propagate(changed,conflict)){
+						return false;
+					}
 				}
+			}else{
+				stats_bv_ops_skipped++;
 			}
 
 			vec<int> & compare = compares[bvID];
+			//Comparisons are sorted by threshold. Only comparisons with thresholds >= the over approx can be implied by it,
+			//and only those with thresholds <= the under approx can be implied by the under approx.
+			//If the comparisons were already propagated for some earlier (looser) bounds, then the comparisons implied by
+			//those bounds are already assigned, and only those between the old and new bounds need to be visited.
+			dbg_compares_sorted(bvID);
+			int over_begin = lowerBoundWeight(compare,over_approx[bvID]);
+			int over_end = compare.size();
+			int under_begin = 0;
+			int under_end = upperBoundWeight(compare,under_approx[bvID]);
+			if(compares_synced[bvID]){
+				over_end = std::max(over_begin, upperBoundWeight(compare,compares_over[bvID]));
+				under_begin = std::min(under_end, lowerBoundWeight(compare,compares_under[bvID]));
+			}
+			stats_compares_visited+= (over_end-over_begin) + (under_end-under_begin);
+			stats_compares_skipped+= compare.size()*2 - ((over_end-over_begin) + (under_end-under_begin));
 			//update over approx lits.
-			//It might be worth doing a binary search here...
-			for(int i = 0;i<compare.size();i++){
+			for(int i = over_begin;i<over_end;i++){
 				int cID = compare[i];
 
 				assert( getOperation(cID).getType()==OperationType::cause_is_comparison);
@@ -6247,7 +6422,7 @@ public:
 					return false;
 			}
 
-			for(int i=compare.size()-1;i>=0;i--){
+			for(int i=under_end-1;i>=under_begin;i--){
 				int cID = compare[i];
 				assert( getOperation(cID).getType()==OperationType::cause_is_comparison);
 				ComparisonOp & c = (ComparisonOp &) getOperation(cID);
@@ -6255,6 +6430,19 @@ public:
 				if(!c.propagate(changed,conflict,false))
 					return false;
 			}
+			//comparisons that were assigned since the last propagation may lie outside of those ranges
+			for(int cID:pending_compares[bvID]){
+				ComparisonOp & c = (ComparisonOp &) getOperation(cID);
+				if(c.bvID!=bvID)
+					continue;
+				stats_compares_visited++;
+				if(!c.propagate(changed,conflict,true) || !c.propagate(changed,conflict,false))
+					return false;
+			}
+			pending_compares[bvID].clear();
+			compares_synced[bvID]=true;
+			compares_under[bvID]=under_approx[bvID];
+			compares_over[bvID]=over_approx[bvID];
 
 			//comparisons to bitvectors.
 			/*vec<int> & bvcompare = bvcompares[bvID];
@@ -6591,7 +6779,7 @@ public:
 	inline void assert_in_range(Weight val, int bvID){
 #ifndef NDEBUG
 		int width = bitvectors[bvID].size();
-		Weight max_val = ((1L)<<width)-1;
+		Weight max_val = BVWeight<Weight>::maxValue(width);
 		assert(val>=0);
 		assert(val<=max_val);
 #endif
@@ -6607,7 +6795,7 @@ public:
 	}
 	inline void clip_over(Weight & val, int bvID){
 		int width = bitvectors[bvID].size();
-		Weight max_val = ((1L)<<width)-1;
+		Weight max_val = BVWeight<Weight>::maxValue(width);
 		if(val>max_val)
 			val=max_val;
 	}
@@ -6621,7 +6809,7 @@ public:
 			return false;
 		}
 		int width = bitvectors[bvID].size();
-		Weight max_val = ((1L)<<width)-1;
+		Weight max_val = BVWeight<Weight>::maxValue(width);
 		if (op==Comparison::leq && to>= max_val){
 			return false;
 		}else if (op==Comparison::lt && to>max_val){
@@ -7181,6 +7369,10 @@ public:
 		pending_under_analyses.growTo(bvID+1,-1);
 		pending_over_analyses.growTo(bvID+1,-1);
 		bv_needs_propagation.growTo(bvID+1);
+		compares_synced.growTo(bvID+1,false);
+		compares_under.growTo(bvID+1);
+		compares_over.growTo(bvID+1);
+		pending_compares.growTo(bvID+1);
 		bv_needs_propagation[bvID]=true;
 
 		if(under_approx[bvID]>-1){
@@ -7188,7 +7380,7 @@ public:
 		}
 		under_approx[bvID]=0;
 		if(vars.size()>0)
-			over_approx[bvID]=(1L<<vars.size())-1;
+			over_approx[bvID]=BVWeight<Weight>::maxValue(vars.size());
 		else
 			over_approx[bvID]=0;
 		under_approx0[bvID]=under_approx[bvID];
@@ -7439,6 +7631,9 @@ public:
 		if(bvID==792){
 			int a=1;
 		}
+		if(bitwidth> (sizeof(Weight) *8)-1){
+			throw std::runtime_error("Bit widths larger than " + std::to_string((sizeof(Weight) *8)-1) + " are not currently supported  (was " + std::to_string(bitwidth) + ")");
+		}
 
 		//bv_callbacks.growTo(id+1,nullptr);
 
@@ -7463,13 +7658,17 @@ public:
 		pending_under_analyses.growTo(bvID+1,-1);
 		pending_over_analyses.growTo(bvID+1,-1);
 		bv_needs_propagation.growTo(bvID+1);
+		compares_synced.growTo(bvID+1,false);
+		compares_under.growTo(bvID+1);
+		compares_over.growTo(bvID+1);
+		pending_compares.growTo(bvID+1);
 		bv_needs_propagation[bvID]=true;
 		//bv_callbacks.growTo(bvID+1);
 		if(under_approx[bvID]>-1){
 			throw std::invalid_argument("Redefined bitvector ID " + std::to_string(bvID) );
 		}
 		under_approx[bvID]=0;
-		over_approx[bvID]=(1L<<bitwidth)-1;
+		over_approx[bvID]=BVWeight<Weight>::maxValue(bitwidth);
 		under_approx0[bvID]=under_approx[bvID];
 		over_approx0[bvID]=over_approx[bvID];
 
@@ -7484,6 +7683,10 @@ public:
 
 
 		bv_needs_propagation.growTo(bvID+1);
+		compares_synced.growTo(bvID+1,false);
+		compares_under.growTo(bvID+1);
+		compares_over.growTo(bvID+1);
+		pending_compares.growTo(bvID+1);
 		bv_needs_propagation[bvID]=true;
 		alteredBV[bvID]=true;
 		altered_bvs.push(bvID);
@@ -7527,13 +7730,17 @@ public:
 		pending_under_analyses.growTo(bvID+1,-1);
 		pending_over_analyses.growTo(bvID+1,-1);
 		bv_needs_propagation.growTo(bvID+1);
+		compares_synced.growTo(bvID+1,false);
+		compares_under.growTo(bvID+1);
+		compares_over.growTo(bvID+1);
+		pending_compares.growTo(bvID+1);
 		bv_needs_propagation[bvID]=true;
 		//bv_callbacks.growTo(bvID+1);
 		if(under_approx[bvID]>-1){
 			throw std::invalid_argument("Redefined bitvector ID " + std::to_string(bvID) );
 		}
 		under_approx[bvID]=0;
-		over_approx[bvID]=(1L<<bitwidth)-1;
+		over_approx[bvID]=BVWeight<Weight>::maxValue(bitwidth);
 		under_approx0[bvID]=under_approx[bvID];
 		over_approx0[bvID]=over_approx[bvID];
 
@@ -7543,7 +7750,7 @@ public:
 				Weight val = constval;
 				//for now, just bitblast this constant value.
 				for (int i = bitwidth-1;i>=0;i--){
-					Weight v = 1L<<i;
+					Weight v = BVWeight<Weight>::bit(i);
 					if (val>=v){
 						val-=v;
 						bitvectors[bvID][i] = True();
@@ -7563,6 +7770,10 @@ public:
 		}
 
 		bv_needs_propagation.growTo(bvID+1);
+		compares_synced.growTo(bvID+1,false);
+		compares_under.growTo(bvID+1);
+		compares_over.growTo(bvID+1);
+		pending_compares.growTo(bvID+1);
 		bv_needs_propagation[bvID]=true;
 		alteredBV[bvID]=true;
 		altered_bvs.push(bvID);
@@ -7691,6 +7902,42 @@ private:
 		return low;
 	}
 
+	struct CompareLt{
+		BVTheorySolver & theory;
+		CompareLt(BVTheorySolver & theory):theory(theory){}
+		bool operator()(int cID1, int cID2)const{
+			return ((ComparisonOp &) theory.getOperation(cID1)).w < ((ComparisonOp &) theory.getOperation(cID2)).w;
+		}
+	};
+
+	//Returns the index of the first comparison in (sorted) compares whose threshold is >= w (or compares.size(), if there is none).
+	int lowerBoundWeight(vec<int> & compares, const Weight & w){
+		int low = 0;
+		int high = compares.size();
+		while(low<high){
+			int midpoint = low + (high - low)/2;
+			if(((ComparisonOp &) getOperation(compares[midpoint])).w < w)
+				low = midpoint+1;
+			else
+				high = midpoint;
+		}
+		return low;
+	}
+
+	//Returns the index of the first comparison in (sorted) compares whose threshold is > w (or compares.size(), if there is none).
+	int upperBoundWeight(vec<int> & compares, const Weight & w){
+		int low = 0;
+		int high = compares.size();
+		while(low<high){
+			int midpoint = low + (high - low)/2;
+			if(w < ((ComparisonOp &) getOperation(compares[midpoint])).w)
+				high = midpoint;
+			else
+				low = midpoint+1;
+		}
+		return low;
+	}
+
 	//Returns a CID comparing to the same bitvector if one exists,  returns the index this CID should be insert after otherwise
 	int binary_search_CID(vec<int> & compares,  int compareID)
 	{
@@ -7837,6 +8084,7 @@ public:
 		}
 
 		dbg_compares_sorted(bvID);
+		compares_synced[bvID]=false;
 
 
 		comparison_needs_repropagation.growTo(operations.size());
@@ -8515,7 +8763,7 @@ Weight BVTheorySolver<Weight>::lowest(int bvID){
 	    vec<Lit> & bv = bitvectors[bvID];
 	    for (int i = 0;i<bv.size();i++){
 	        if (value(bv[i])==l_True)
-	            val += ((Weight )1)<<i;
+	            BVWeight<Weight>::set(val,i);
 	    }
 	    return val;
 	}
@@ -8525,7 +8773,7 @@ template<typename Weight>
 	    vec<Lit> & bv = bitvectors[bvID];
 	    for (int i = 0;i<bv.size();i++){
 	        if (value(bv[i])!=l_False)
-	            val += ((Weight )1)<<i;
+	            BVWeight<Weight>::set(val,i);
 	    }
 	    return val;
 	}
@@ -8566,7 +8814,7 @@ void BVTheorySolver<Weight>::dbg_evaluate(int bvID, int pos,vec<Weight> & vals,W
     }
     vec<Lit> & bv = bitvectors[bvID];
     if (value(bv[pos]) ==l_True or value(bv[pos]) ==l_Undef){
-    	Weight bit = (1<<pos);
+    	Weight bit = BVWeight<Weight>::bit(pos);
 		dbg_evaluate(bvID,pos-1,vals, val+bit);
     }
     if (value(bv[pos]) ==l_False or value(bv[pos]) ==l_Undef)
@@ -8612,194 +8860,113 @@ Weight BVTheorySolver<Weight>::refine_lbound_check(int bvID, Weight bound, Var i
     return 0;
 }
 
-	template<typename Weight>
-	Weight BVTheorySolver<Weight>::refine_ubound(int bvID, Weight bound, Var ignore_bit){
+//Returns the lowest value >= bound that is consistent with the assigned bits of the bitvector (treating ignore_bit as unassigned), or -1 if there is none.
+//This is a single pass from the most significant bit down: the first bit at which the bound disagrees with the assignment determines
+//whether the bound must be raised at that bit, or at the lowest unassigned 0-bit of the bound above it.
+template<typename Weight>
+Weight BVTheorySolver<Weight>::refine_ubound(int bvID, Weight bound, Var ignore_bit){
 #ifndef NDEBUG
-		Weight expected = refine_ubound_check(bvID,bound,ignore_bit);
+	Weight expected = refine_ubound_check(bvID,bound,ignore_bit);
 #endif
-		//Weight under_old = under_approx[bvID];
-		//Weight over_old = over_approx[bvID];
-		vec<Lit> & bv = bitvectors[bvID];
-		bool done = false;
-		//under_causes[bvID].clear();
-		//over_causes[bvID].clear();
-		int last_set_x =-1;
-		int j = bv.size()-1;
-
-
-		Weight proposed_bound=0;
-		for(int i = bv.size()-1; i>=0 && ! done;i--){
-
-			Weight ibit = ((Weight )1)<<i;
-			if ((value(bv[i])!=l_True || var(bv[i])==ignore_bit) && (bound & (ibit))){
-				bool found=false;
-				while(j>=i){
-					Weight jbit = ((Weight )1)<<j;
-					if ((value(bv[j])==l_Undef || var(bv[j])==ignore_bit) && !(proposed_bound & jbit) ){
-						//bv[j] must also not have been used yet as a flip value for this case (else we should try the (!(bound & (jbit))) case)...
-						last_set_x=j;
-					}else if  (!(bound & (jbit)) && ((value(bv[j])==l_True || var(bv[j])==ignore_bit || (proposed_bound & jbit)))){
-						found=true;
-						last_set_x=-1;
-						//if j is > than i, then we are done.
-						if (j>i){
-							done=true;
-							break;
-						}
-					}
-					j--;
-				}
-				if (last_set_x  >-1){
-					found=true;
-					//#we were forced to set an xbit to 1 to match this ibit.
-					Weight xbit = ((Weight )1)<<last_set_x;
-					assert(!(proposed_bound & xbit));
-					proposed_bound|=xbit;
-					//mp[last_set_x]='s'
-					if (last_set_x>i){
-						//#mp is > i, so we are done
-						done=true;
-						break;
-					}else{
-						assert(last_set_x==i);
-						j=bv.size()-1;//can we do better than this?
-					}
-					last_set_x=-1;
-				}
-
-				if (! found){
+	vec<Lit> & bv = bitvectors[bvID];
+	int width = bv.size();
+	if(bound>BVWeight<Weight>::maxValue(width)){
+		assert(expected==-1);
+		return -1;
+	}
+	if(bound<0)
+		bound=0;
+	Weight refined_bound = bound;
+	int raise_bit = -1;//the lowest bit seen so far that is 0 in the bound, and may be set to 1
+	int i = width-1;
+	for(;i>=0;i--){
+		lbool val = var(bv[i])==ignore_bit ? l_Undef : value(bv[i]);
+		if(BVWeight<Weight>::test(bound,i)){
+			if(val==l_False){
+				//this bit must be 0, so the value must exceed the bound in some higher bit
+				if(raise_bit<0){
 					assert(expected==-1);
 					return -1;
 				}
+				i=raise_bit;
+				break;
 			}
+		}else if (val==l_True){
+			//this bit must be 1, so the value exceeds the bound here
+			break;
+		}else if (val==l_Undef){
+			raise_bit=i;
 		}
-		Weight refined_bound=lowest(bvID);
-	    j =bv.size()-1;
-		while (j>=0){
-			Weight jbit = ((Weight )1)<<j;
-			if (proposed_bound & jbit){
-				assert(!(refined_bound & jbit));
-				refined_bound |=jbit;
-				if (!(bound & (jbit))){
-					break;
-				}
-
-			}
-			j--;
+	}
+	if(i>=0){
+		//keep the bound's bits above i, set bit i, and take the lowest consistent value for the bits below it
+		refined_bound = bound & ~BVWeight<Weight>::maxValue(i+1);
+		BVWeight<Weight>::set(refined_bound,i);
+		for(int j = 0;j<i;j++){
+			if(value(bv[j])==l_True && var(bv[j])!=ignore_bit)
+				BVWeight<Weight>::set(refined_bound,j);
 		}
-
-
-	    if(refined_bound< bound){
-	    	assert(expected==-1);
-	        return -1;
-	    }
-	        //#return ubound(ibits,mbits2)
+	}
 #ifndef NDEBUG
-		if(refined_bound!=expected){
-			assert(false);
-			exit(5);
-		}
-#endif
-	    return refined_bound;
+	if(refined_bound!=expected){
+		assert(false);
+		exit(5);
 	}
+#endif
+	return refined_bound;
+}
+
+//Returns the highest value <= bound that is consistent with the assigned bits of the bitvector (treating ignore_bit as unassigned), or -1 if there is none.
+//This is the mirror image of refine_ubound.
 template<typename Weight>
-Weight BVTheorySolver<Weight>::refine_lbound(int bvID, Weight obound, Var ignore_bit){
+Weight BVTheorySolver<Weight>::refine_lbound(int bvID, Weight bound, Var ignore_bit){
 #ifndef NDEBUG
-	Weight expected = refine_lbound_check(bvID,obound,ignore_bit);
+	Weight expected = refine_lbound_check(bvID,bound,ignore_bit);
 #endif
-/*	static int iter = 0;
-	if(++iter==22739){
-		int a=1;
-	}*/
-	//Weight under_old = under_approx[bvID];
-	//Weight over_old = over_approx[bvID];
 	vec<Lit> & bv = bitvectors[bvID];
-	bool done = false;
-	//under_causes[bvID].clear();
-	//over_causes[bvID].clear();
-
-	int j = bv.size()-1;
-	int last_set_x =-1;
-	Weight bound = ~obound;
-
-	Weight proposed_bound=0;
-	for(int i = bv.size()-1; i>=0 && ! done;i--){
-
-		Weight ibit = ((Weight )1)<<i;
-		if ((value(bv[i])!=l_False || var(bv[i])==ignore_bit) && (bound & (ibit))){
-			bool found=false;
-			while(j>=i){
-				Weight jbit = ((Weight )1)<<j;
-				if ((value(bv[j])==l_Undef || var(bv[j])==ignore_bit) && !(proposed_bound & jbit) ){
-					//bv[j] must also not have been used yet as a flip value for this case (else we should try the (!(bound & (jbit))) case)...
-					last_set_x=j;
-				}else if  (!(bound & (jbit)) && ((value(bv[j])==l_False || var(bv[j])==ignore_bit || (proposed_bound & jbit)))){
-					found=true;
-					last_set_x=-1;
-					//if j is > than i, then we are done.
-					if (j>i){
-						done=true;
-						break;
-					}
-				}
-				j--;
-			}
-			if (last_set_x  >-1){
-				found=true;
-				//#we were forced to set an xbit to 1 to match this ibit.
-				Weight xbit = ((Weight )1)<<last_set_x;
-				assert(!(proposed_bound & xbit));
-				proposed_bound|=xbit;
-				//mp[last_set_x]='s'
-				if (last_set_x>i){
-					//#mp is > i, so we are done
-					done=true;
-					break;
-				}else{
-					assert(last_set_x==i);
-					j=bv.size()-1;//can we do better than this?
-				}
-				last_set_x =-1;
-			}
-
-			if (! found){
-				assert(expected==-1);
-				return -1;
-			}
-		}
-	}
-	Weight refined_bound= 0;//(bvID);
-	for (int i = 0;i<bv.size();i++){
-		if (value(bv[i])==l_False)
-			refined_bound += ((Weight )1)<<i;
+	int width = bv.size();
+	if(bound<0){
+		assert(expected==-1);
+		return -1;
 	}
-	j =bv.size()-1;
-	while (j>=0){
-		Weight jbit = ((Weight )1)<<j;
-		if (proposed_bound & jbit){
-			assert(!(refined_bound & jbit));
-			refined_bound |=jbit;
-			if (!(bound & (jbit))){
+	Weight max_val = BVWeight<Weight>::maxValue(width);
+	if(bound>max_val)
+		bound=max_val;
+	Weight refined_bound = bound;
+	int lower_bit = -1;//the lowest bit seen so far that is 1 in the bound, and may be set to 0
+	int i = width-1;
+	for(;i>=0;i--){
+		lbool val = var(bv[i])==ignore_bit ? l_Undef : value(bv[i]);
+		if(!BVWeight<Weight>::test(bound,i)){
+			if(val==l_True){
+				//this bit must be 1, so the value must be below the bound in some higher bit
+				if(lower_bit<0){
+					assert(expected==-1);
+					return -1;
+				}
+				i=lower_bit;
 				break;
 			}
-
+		}else if (val==l_False){
+			//this bit must be 0, so the value is below the bound here
+			break;
+		}else if (val==l_Undef){
+			lower_bit=i;
 		}
-		j--;
 	}
-
-	refined_bound = (1L<<bv.size()) + ~refined_bound;
-	if(refined_bound> obound){
-		assert(expected==-1);
-		return -1;
+	if(i>=0){
+		//keep the bound's bits above i, clear bit i, and take the highest consistent value for the bits below it
+		refined_bound = bound & ~BVWeight<Weight>::maxValue(i+1);
+		for(int j = 0;j<i;j++){
+			if(value(bv[j])!=l_False || var(bv[j])==ignore_bit)
+				BVWeight<Weight>::set(refined_bound,j);
+		}
 	}
-
-		//#return ubound(ibits,mbits2)
-
 #ifndef NDEBUG
-		if(refined_bound!=expected){
-			assert(false);
-			exit(5);
-		}
+	if(refined_bound!=expected){
+		assert(false);
+		exit(5);
+	}
 #endif
 	return refined_bound;
 }
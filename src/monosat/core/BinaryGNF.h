@@ -0,0 +1,453 @@
+/****************************************************************************************[BinaryGNF.h]
+ The MIT License (MIT)
+
+ Copyright (c) 2014, Sam Bayless
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ associated documentation files (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or
+ substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **************************************************************************************************/
+
+#ifndef BINARYGNF_H_
+#define BINARYGNF_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#if not defined(__MINGW32__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Monosat {
+
+/**
+ * A binary serialization of the GNF format, intended for very large generated instances.
+ *
+ * The file starts with a 16 byte header (magic, version, byte order marker, reserved), followed by a sequence of records.
+ * Each record is an 8 byte header (type, payload size in bytes), followed by the payload, padded to a multiple of 8 bytes:
+ *
+ * - Clauses: {count, 0}, followed by a contiguous array of count int32 literals in DIMACS form, each clause terminated by 0.
+ * - Edges:   {graph, weighted, count, 0}, followed by int32 arrays from[count], to[count], var[count],
+ *            and (if weighted) an int64 array weight[count]. Variables are in DIMACS form (1-based), as in 'edge' lines.
+ * - Line:    any other GNF line (including bitvectors, PB constraints, theory atoms, and solve statements),
+ *            stored verbatim with its trailing newline and a terminating 0, so it can be handed to the text parsers in place.
+ *
+ * Clauses and edges, which make up the bulk of large instances, are read directly out of the (memory mapped) file,
+ * without tokenizing. The format uses native byte order; files with a different byte order are rejected.
+ */
+namespace BinaryGNF {
+static const char magic[4] = { 'G', 'N', 'F', 'B' };
+static const uint32_t version = 1;
+static const uint32_t byte_order = 0x01020304;
+static const size_t header_size = 16;
+
+enum RecordType {
+	RECORD_CLAUSES = 1, RECORD_EDGES = 2, RECORD_LINE = 3
+};
+
+struct RecordHeader {
+	uint32_t type;
+	uint32_t bytes;
+};
+
+struct ClausesHeader {
+	int32_t count;
+	int32_t reserved;
+};
+
+struct EdgesHeader {
+	int32_t graphID;
+	int32_t weighted;
+	int32_t count;
+	int32_t reserved;
+};
+
+inline size_t padded(size_t bytes) {
+	return (bytes + 7) & ~((size_t) 7);
+}
+
+//Returns true if the named file starts with the binary GNF magic number.
+inline bool isBinaryFile(const char * filename) {
+	if (!filename)
+		return false;
+	FILE * f = fopen(filename, "rb");
+	if (!f)
+		return false;
+	char buf[4];
+	bool is_binary = fread(buf, 1, 4, f) == 4 && memcmp(buf, magic, 4) == 0;
+	fclose(f);
+	return is_binary;
+}
+}
+
+/**
+ * Writes binary GNF.
+ * Accepts plain GNF text (in arbitrary fragments, via write() or writef()), and re-encodes it line by line:
+ * clauses and integer weighted edge lines are collected into blocks, comments are dropped,
+ * and all other lines are stored verbatim.
+ * Blocks are only written out when a line record follows them, when they grow large, or on flush(),
+ * so the output is only complete after flush() or close().
+ */
+class BinaryGNFWriter {
+	FILE * out = nullptr;
+	std::string line;
+	std::vector<int32_t> clauses;
+	std::vector<int64_t> tokens;
+
+	int edge_graph = -1;
+	bool edge_weighted = false;
+	std::vector<int32_t> edge_from;
+	std::vector<int32_t> edge_to;
+	std::vector<int32_t> edge_var;
+	std::vector<int64_t> edge_weight;
+
+	static const size_t max_block_ints = 1 << 20;
+	static const size_t max_block_edges = 1 << 18;
+
+public:
+	long stats_clauses = 0;
+	long stats_edges = 0;
+	long stats_lines = 0;
+
+	explicit BinaryGNFWriter(FILE * out) :
+			out(out) {
+		char header[BinaryGNF::header_size];
+		memset(header, 0, sizeof(header));
+		memcpy(header, BinaryGNF::magic, 4);
+		memcpy(header + 4, &BinaryGNF::version, 4);
+		memcpy(header + 8, &BinaryGNF::byte_order, 4);
+		writeBytes(header, sizeof(header));
+	}
+	~BinaryGNFWriter() {
+		close();
+	}
+
+	void write(const char * data, size_t len) {
+		for (size_t i = 0; i < len; i++) {
+			if (data[i] == '\n') {
+				processLine(line);
+				line.clear();
+			} else {
+				line.push_back(data[i]);
+			}
+		}
+	}
+	void write(const char * data) {
+		write(data, strlen(data));
+	}
+	void vwritef(const char * fmt, va_list args) {
+		char buf[256];
+		va_list args2;
+		va_copy(args2, args);
+		int n = vsnprintf(buf, sizeof(buf), fmt, args);
+		if (n < 0) {
+			va_end(args2);
+			throw std::runtime_error("Failed to format binary GNF output");
+		} else if (n < (int) sizeof(buf)) {
+			write(buf, n);
+		} else {
+			std::vector<char> big(n + 1);
+			vsnprintf(big.data(), big.size(), fmt, args2);
+			write(big.data(), n);
+		}
+		va_end(args2);
+	}
+	void writef(const char * fmt, ...) {
+		va_list args;
+		va_start(args, fmt);
+		vwritef(fmt, args);
+		va_end(args);
+	}
+
+	//Write out any buffered blocks (but not an unterminated partial line).
+	void flush() {
+		if (!out)
+			return;
+		flushClauses();
+		flushEdges();
+		fflush(out);
+	}
+
+	void close() {
+		if (!out)
+			return;
+		if (line.size()) {
+			processLine(line);
+			line.clear();
+		}
+		flush();
+		out = nullptr;
+	}
+
+private:
+	void writeBytes(const void * data, size_t bytes) {
+		if (bytes && fwrite(data, 1, bytes, out) != bytes) {
+			throw std::runtime_error("Failed to write binary GNF output");
+		}
+	}
+	void writeRecord(uint32_t type, const void * data, size_t bytes, const void * data2 = nullptr, size_t bytes2 = 0,
+			const void * data3 = nullptr, size_t bytes3 = 0, const void * data4 = nullptr, size_t bytes4 = 0,
+			const void * data5 = nullptr, size_t bytes5 = 0) {
+		static const char zeros[8] = { 0 };
+		size_t total = bytes + bytes2 + bytes3 + bytes4 + bytes5;
+		size_t pad = BinaryGNF::padded(total) - total;
+		if (BinaryGNF::padded(total) > UINT32_MAX)
+			throw std::runtime_error("Binary GNF record too large");
+		BinaryGNF::RecordHeader h;
+		h.type = type;
+		h.bytes = BinaryGNF::padded(total);
+		writeBytes(&h, sizeof(h));
+		writeBytes(data, bytes);
+		writeBytes(data2, bytes2);
+		writeBytes(data3, bytes3);
+		writeBytes(data4, bytes4);
+		writeBytes(data5, bytes5);
+		writeBytes(zeros, pad);
+	}
+
+	void flushClauses() {
+		if (clauses.size()) {
+			BinaryGNF::ClausesHeader ch;
+			ch.count = clauses.size();
+			ch.reserved = 0;
+			writeRecord(BinaryGNF::RECORD_CLAUSES, &ch, sizeof(ch), clauses.data(), clauses.size() * sizeof(int32_t));
+			clauses.clear();
+		}
+	}
+	void flushEdges() {
+		if (edge_from.size()) {
+			BinaryGNF::EdgesHeader eh;
+			eh.graphID = edge_graph;
+			eh.weighted = edge_weighted;
+			eh.count = edge_from.size();
+			eh.reserved = 0;
+			size_t n = edge_from.size();
+			//pad the int32 arrays so that the weights are 8 byte aligned
+			if (n % 2)
+				edge_var.push_back(0);
+			writeRecord(BinaryGNF::RECORD_EDGES, &eh, sizeof(eh), edge_from.data(), n * sizeof(int32_t), edge_to.data(),
+					n * sizeof(int32_t), edge_var.data(), edge_var.size() * sizeof(int32_t), edge_weighted ? edge_weight.data() : nullptr,
+					edge_weighted ? n * sizeof(int64_t) : 0);
+			edge_from.clear();
+			edge_to.clear();
+			edge_var.clear();
+			edge_weight.clear();
+		}
+	}
+	void writeLine(const char * begin, size_t len) {
+		flushClauses();
+		flushEdges();
+		std::string ln(begin, len);
+		ln.push_back('\n');
+		writeRecord(BinaryGNF::RECORD_LINE, ln.c_str(), ln.size() + 1);
+		stats_lines++;
+	}
+
+	//Split a line into integers; returns false if any token is not a plain decimal integer.
+	bool tokenize(const char * p, const char * end) {
+		tokens.clear();
+		while (p < end) {
+			while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+				p++;
+			if (p == end)
+				break;
+			bool neg = false;
+			if (*p == '-' || *p == '+') {
+				neg = *p == '-';
+				p++;
+			}
+			if (p == end || *p < '0' || *p > '9')
+				return false;
+			int64_t val = 0;
+			while (p < end && *p >= '0' && *p <= '9') {
+				if (val > (INT64_MAX - 9) / 10)
+					return false;
+				val = val * 10 + (*p - '0');
+				p++;
+			}
+			if (p < end && *p != ' ' && *p != '\t' && *p != '\r')
+				return false;
+			tokens.push_back(neg ? -val : val);
+		}
+		return true;
+	}
+	static bool fitsInt(int64_t v) {
+		return v >= INT32_MIN && v <= INT32_MAX;
+	}
+
+	void processLine(const std::string & ln) {
+		const char * p = ln.c_str();
+		const char * end = p + ln.size();
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+			p++;
+		if (p == end || *p == 'c')
+			return; //blank lines and comments are dropped
+		if ((*p == '-' || (*p >= '0' && *p <= '9')) && tokenize(p, end) && tokens.size() && tokens.back() == 0) {
+			bool ok = true;
+			for (int64_t t : tokens)
+				ok &= fitsInt(t);
+			if (ok) {
+				flushEdges();
+				//a line may hold several zero terminated clauses
+				for (int64_t t : tokens) {
+					clauses.push_back((int32_t) t);
+					if (t == 0)
+						stats_clauses++;
+				}
+				if (clauses.size() >= max_block_ints)
+					flushClauses();
+				return;
+			}
+		}
+		if (strncmp(p, "edge ", 5) == 0 || strncmp(p, "weighted_edge ", 14) == 0) {
+			const char * args = p + (*p == 'e' ? 5 : 14);
+			if (tokenize(args, end) && (tokens.size() == 4 || tokens.size() == 5) && fitsInt(tokens[0])
+					&& fitsInt(tokens[1]) && fitsInt(tokens[2]) && fitsInt(tokens[3]) && tokens[0] >= 0 && tokens[3] > 0
+					&& (tokens.size() == 4 || fitsInt(tokens[4]))) {
+				bool weighted = tokens.size() == 5;
+				if (edge_from.size() && (edge_graph != tokens[0] || edge_weighted != weighted))
+					flushEdges();
+				flushClauses();
+				edge_graph = tokens[0];
+				edge_weighted = weighted;
+				edge_from.push_back(tokens[1]);
+				edge_to.push_back(tokens[2]);
+				edge_var.push_back(tokens[3]);
+				if (weighted)
+					edge_weight.push_back(tokens[4]);
+				stats_edges++;
+				if (edge_from.size() >= max_block_edges)
+					flushEdges();
+				return;
+			}
+		}
+		writeLine(p, end - p);
+	}
+};
+
+/**
+ * Reads binary GNF, memory mapping the file where possible.
+ * The mapping is private and writable, so that line records can be handed to the (destructive) text parsers in place.
+ */
+class BinaryGNFReader {
+	char * data = nullptr;
+	size_t size = 0;
+	size_t pos = 0;
+	bool mapped = false;
+
+	void fail(const char * filename, const char * msg) {
+		std::string s = std::string("ERROR! ") + msg + ": " + filename;
+		throw std::runtime_error(s);
+	}
+
+public:
+	struct Record {
+		uint32_t type;
+		char * payload;
+		size_t bytes;
+	};
+
+	explicit BinaryGNFReader(const char * filename) {
+#if not defined(__MINGW32__)
+		int fd = open(filename, O_RDONLY);
+		if (fd < 0)
+			fail(filename, "Could not open file");
+		struct stat st;
+		if (fstat(fd, &st) != 0) {
+			::close(fd);
+			fail(filename, "Could not stat file");
+		}
+		size = st.st_size;
+		if (size > 0) {
+			void * mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+			if (mem == MAP_FAILED) {
+				::close(fd);
+				fail(filename, "Could not map file");
+			}
+			madvise(mem, size, MADV_SEQUENTIAL);
+			data = (char*) mem;
+			mapped = true;
+		}
+		::close(fd);
+#else
+		FILE * f = fopen(filename, "rb");
+		if (!f)
+			fail(filename, "Could not open file");
+		fseek(f, 0, SEEK_END);
+		size = ftell(f);
+		fseek(f, 0, SEEK_SET);
+		data = (char*) malloc(size ? size : 1);
+		if (!data || fread(data, 1, size, f) != size) {
+			fclose(f);
+			fail(filename, "Could not read file");
+		}
+		fclose(f);
+#endif
+		if (size < BinaryGNF::header_size || memcmp(data, BinaryGNF::magic, 4) != 0)
+			fail(filename, "Not a binary GNF file");
+		uint32_t v, order;
+		memcpy(&v, data + 4, 4);
+		memcpy(&order, data + 8, 4);
+		if (order != BinaryGNF::byte_order)
+			fail(filename, "Binary GNF file has the wrong byte order");
+		if (v != BinaryGNF::version)
+			fail(filename, "Unsupported binary GNF version");
+		pos = BinaryGNF::header_size;
+	}
+
+	~BinaryGNFReader() {
+#if not defined(__MINGW32__)
+		if (mapped)
+			munmap(data, size);
+#else
+		free(data);
+#endif
+	}
+
+	bool eof() const {
+		return pos >= size;
+	}
+
+	//Returns false at the end of the file. Throws if the file is truncated.
+	bool next(Record & r) {
+		if (eof())
+			return false;
+		if (size - pos < sizeof(BinaryGNF::RecordHeader))
+			throw std::runtime_error("Truncated binary GNF record");
+		BinaryGNF::RecordHeader h;
+		memcpy(&h, data + pos, sizeof(h));
+		pos += sizeof(h);
+		if (h.bytes > size - pos)
+			throw std::runtime_error("Truncated binary GNF record");
+		r.type = h.type;
+		r.payload = data + pos;
+		r.bytes = h.bytes;
+		pos += h.bytes;
+		return true;
+	}
+};
+
+}
+
+#endif /* BINARYGNF_H_ */
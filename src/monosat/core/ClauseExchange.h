@@ -0,0 +1,208 @@
+/****************************************************************************************[ClauseExchange.h]
+ The MIT License (MIT)
+
+ Copyright (c) 2014, Sam Bayless
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ associated documentation files (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or
+ substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **************************************************************************************************/
+
+#ifndef CLAUSEEXCHANGE_H_
+#define CLAUSEEXCHANGE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include "monosat/mtl/Vec.h"
+#include "monosat/core/SolverTypes.h"
+
+#if not defined(__MINGW32__)
+#include <sys/mman.h>
+#endif
+
+namespace Monosat {
+
+/**
+ * Lock-free exchange of short learnt clauses between portfolio workers.
+ * The exchange lives in anonymous shared memory, so it must be created before the worker processes are forked.
+ * Each worker owns one ring buffer, which only it writes to; all other workers read from it.
+ * Clauses are stored as a length followed by the literals; a reader that falls more than a full ring
+ * behind the writer simply skips ahead (losing those clauses), so writers never block.
+ *
+ * Only clauses over variables that existed when the workers were forked (and so have the same meaning in every worker)
+ * are exchanged.
+ */
+class ClauseExchange {
+	struct Header {
+		std::atomic<int> winner;
+		int n_workers;
+		int capacity;
+	};
+	struct Ring {
+		std::atomic<uint64_t> head;
+	};
+
+	char * shared = nullptr;
+	size_t shared_size = 0;
+	int n_workers = 0;
+	int capacity = 0;//number of ints in each ring (a power of 2)
+	int worker = -1;
+	Var max_shared_var = 0;
+	int max_length = 0;
+	vec<uint64_t> read_pos;
+	vec<int32_t> tmp;
+	vec<Lit> tmp_clause;
+
+	Header * header() {
+		return (Header*) shared;
+	}
+	size_t ringBytes() const {
+		return sizeof(Ring) + sizeof(std::atomic<int32_t>) * capacity;
+	}
+	Ring * ring(int w) {
+		return (Ring*) (shared + sizeof(Header) + ringBytes() * w);
+	}
+	std::atomic<int32_t> * data(int w) {
+		return (std::atomic<int32_t>*) (((char*) ring(w)) + sizeof(Ring));
+	}
+public:
+	int64_t stats_exported = 0;
+	int64_t stats_imported = 0;
+	int64_t stats_dropped = 0;
+
+	ClauseExchange(int n_workers, int max_length, int capacity = 1 << 16) :
+			n_workers(n_workers), capacity(capacity), max_length(max_length) {
+		assert((capacity & (capacity - 1)) == 0);
+		shared_size = sizeof(Header) + ringBytes() * n_workers;
+#if not defined(__MINGW32__)
+		void * mem = mmap(nullptr, shared_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if (mem == MAP_FAILED) {
+			throw std::runtime_error("Failed to allocate shared memory for clause exchange");
+		}
+		shared = (char*) mem;
+#else
+		throw std::runtime_error("Clause exchange is not supported on this platform");
+#endif
+		Header * h = new (shared) Header();
+		h->winner = -1;
+		h->n_workers = n_workers;
+		h->capacity = capacity;
+		for (int w = 0; w < n_workers; w++) {
+			Ring * r = new (ring(w)) Ring();
+			r->head = 0;
+			std::atomic<int32_t> * d = data(w);
+			for (int i = 0; i < capacity; i++)
+				new (&d[i]) std::atomic<int32_t>(0);
+		}
+		read_pos.growTo(n_workers, 0);
+	}
+
+	~ClauseExchange() {
+#if not defined(__MINGW32__)
+		if (shared)
+			munmap(shared, shared_size);
+#endif
+	}
+
+	//Must be called in each worker after forking.
+	void setWorker(int workerID, Var maxSharedVar) {
+		worker = workerID;
+		max_shared_var = maxSharedVar;
+	}
+	int getWorker() const {
+		return worker;
+	}
+	int nWorkers() const {
+		return n_workers;
+	}
+
+	//Returns true if this worker is the first to claim a result.
+	bool claimWinner() {
+		int expected = -1;
+		return header()->winner.compare_exchange_strong(expected, worker);
+	}
+	bool hasWinner() {
+		return header()->winner.load() >= 0;
+	}
+
+	void exportClause(const vec<Lit> & clause) {
+		if (worker < 0 || clause.size() == 0 || clause.size() > max_length)
+			return;
+		for (Lit l : clause) {
+			if (var(l) >= max_shared_var)
+				return;
+		}
+		Ring * r = ring(worker);
+		std::atomic<int32_t> * d = data(worker);
+		int mask = capacity - 1;
+		uint64_t pos = r->head.load(std::memory_order_relaxed);
+		d[pos & mask].store(clause.size(), std::memory_order_relaxed);
+		for (int i = 0; i < clause.size(); i++) {
+			d[(pos + i + 1) & mask].store(toInt(clause[i]), std::memory_order_relaxed);
+		}
+		r->head.store(pos + clause.size() + 1, std::memory_order_release);
+		stats_exported++;
+	}
+
+	//Call fn(vec<Lit>&) for each clause exported by another worker since the last call.
+	template<class Fn>
+	void importClauses(Fn && fn) {
+		if (worker < 0)
+			return;
+		int mask = capacity - 1;
+		for (int w = 0; w < n_workers; w++) {
+			if (w == worker)
+				continue;
+			Ring * r = ring(w);
+			std::atomic<int32_t> * d = data(w);
+			uint64_t start = read_pos[w];
+			uint64_t head = r->head.load(std::memory_order_acquire);
+			if (head - start > (uint64_t) capacity) {
+				//fell too far behind; skip ahead
+				stats_dropped++;
+				start = head;
+			}
+			tmp.clear();
+			for (uint64_t p = start; p < head; p++) {
+				tmp.push(d[p & mask].load(std::memory_order_relaxed));
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			read_pos[w] = head;
+			if (r->head.load(std::memory_order_relaxed) - start > (uint64_t) capacity) {
+				//the writer overwrote part of what was just read.
+				stats_dropped++;
+				continue;
+			}
+			int i = 0;
+			while (i < tmp.size()) {
+				int sz = tmp[i++];
+				if (sz <= 0 || sz > max_length || i + sz > tmp.size())
+					break;
+				tmp_clause.clear();
+				for (int j = 0; j < sz; j++) {
+					tmp_clause.push(toLit(tmp[i + j]));
+				}
+				i += sz;
+				stats_imported++;
+				fn(tmp_clause);
+			}
+		}
+	}
+};
+
+}
+
+#endif /* CLAUSEEXCHANGE_H_ */
@@ -114,10 +114,16 @@ BoolOption Monosat::opt_theory_decision_round_robin(_cat, "round-robin-theory-or
 BoolOption Monosat::opt_early_theory_prop(_cat, "early-theory-prop",
 		"If false, the solver waits until all literals are propagated before propagating theories; if true, theories are propagated while the solver is still propagating literals",
 		false);
+BoolOption Monosat::opt_theory_equivalences(_cat, "theory-equiv",
+		"Before solving, detect theory atoms whose literals are equivalent through binary clauses, and merge them inside their theory solvers",
+		true);
 
+BoolOption Monosat::opt_async_output(_cat,"async-output","Buffer constraints written through setOutputFile and write them on a background thread, instead of flushing each line (output is only guaranteed to be on disk after each solve call)",false);
  BoolOption Monosat::opt_remap_vars(_cat,"remap-vars","Remap variables in the GNF internally in the solver, to minimize space required",true);
  BoolOption Monosat::opt_decide_optimization_lits(_cat_opt,"decide-opt-lits","Allow decisions on literals introduced by optimization constraints",true);
-IntOption  Monosat::opt_optimization_search_type(_cat_opt,"search","0: Use binary search for optimization. 1: Use linear search. 2: Use binary search, but switch to linear search for hard values.", 0, IntRange(0, 2));
+IntOption  Monosat::opt_optimization_search_type(_cat_opt,"search","0: Use binary search for optimization. 1: Use linear search. 2: Use binary search, but switch to linear search for hard values. 3: Use core-guided search for PB objectives (and binary search for bitvectors).", 0, IntRange(0, 3));
+BoolOption Monosat::opt_core_stratification(_cat_opt,"core-stratify","In core-guided search, assume heavier objective literals before lighter ones",true);
+BoolOption Monosat::opt_core_hardening(_cat_opt,"core-harden","In core-guided search, always assume objective literals that are heavier than the gap between the best model and the lower bound",true);
 DoubleOption Monosat::opt_rnd_optimization_freq(_cat_graph,"search-freq", "",0.5,DoubleRange(0, true, 1, true));
 DoubleOption Monosat::opt_rnd_optimization_restart_freq(_cat_graph,"search-restart-freq", "",0.05,DoubleRange(0, true, 1, true));
 BoolOption  Monosat::opt_strict_search_optimization(_cat_opt,"strict-search","Use strict (rather than >=/<=) constraints during optimization (be warned, this is not always safe!)",false);
@@ -152,7 +158,7 @@ StringOption Monosat::opt_maxflow_alg(_cat_graph, "maxflow",
 		"Select max s-t-flow algorithm (edmondskarp, edmondskarp-adj, edmondskarp-dynamic,dinitz,dinitz-linkcut, kohli-torr)",
 		"kohli-torr"); //ibfs
 StringOption Monosat::opt_reach_alg(_cat_graph, "reach",
-		"Select reachability algorithm (bfs,dfs, dijkstra,ramal-reps,cnf)", "ramal-reps");
+		"Select reachability algorithm (bfs,dfs, dijkstra,ramal-reps,dynamic,cnf)", "ramal-reps");
 StringOption Monosat::opt_dist_alg(_cat_graph, "dist",
 		"Select reachability algorithm (bfs,dfs, dijkstra,ramal-reps,cnf)", "ramal-reps");
 
@@ -186,6 +192,7 @@ IntOption Monosat::opt_adaptive_history_clear(_cat_graph, "adaptive-history-clea
 		0, IntRange(0, INT32_MAX));
 BoolOption Monosat::opt_disable_history_clears(_cat_graph,"disable-history-clear","",false);
 IntOption Monosat::opt_dynamic_history_clear(_cat_graph, "dynamic-history-clear", "0=dont use dynamic history clears,1=use opportunistic dynamic history clears (falling back on normal history clears if that fails), 2=force dynamic history clears",0, IntRange(0, 2));
+BoolOption Monosat::opt_graph_csr(_cat_graph, "graph-csr", "Traverse graphs through a contiguous (compressed sparse row) copy of their adjacency lists, rebuilt when nodes or edges are added", true);
 
 BoolOption Monosat::opt_lazy_backtrack(_cat_graph, "lazy-backtrack", "", false);
 BoolOption Monosat::opt_lazy_backtrack_decisions(_cat_graph, "lazy-backtrack-decisions", "", false);
@@ -321,6 +328,8 @@ BoolOption Monosat::opt_reach_detector_combined_maxflow(_cat_graph, "reach-combi
 IntOption Monosat::opt_adaptive_conflict_mincut(_cat_graph, "adaptive-conflict-mincut",
 		"First try applying conflict detection without mincut analysis (which is faster), then try again with mincut analysis if the learnt clause is >= this length (0 to disable, 1 to always use mincut analysis)",
 		0, IntRange(0, INT32_MAX));
+BoolOption Monosat::opt_maxflow_reason_cache(_cat_graph, "maxflow-reason-cache",
+		"Reuse the explanation of a maximum flow propagation for other flow literals explained from the same graph state", true);
 
 BoolOption Monosat::opt_shortest_path_prune_dist(_cat_graph, "shortest-paths-prune-dist",
 		"Prune edges based on distances from learnt clauses for the shortest paths theory", false);
@@ -350,6 +359,9 @@ BoolOption Monosat::opt_dinics_recursive(_cat_graph, "dinitz-recursive",
 IntOption  Monosat::opt_graph_prop_skip(_cat_graph, "graph-theory-skip",
 		"Only process every nth graph theory propagation ('1' skips no propagations)",1, IntRange(1,INT32_MAX));
 
+IntOption  Monosat::opt_graph_prop_threads(_cat_graph, "graph-prop-threads",
+		"Number of threads used to update graph detectors concurrently during graph theory propagation (0 to disable). Implied literals and conflicts are still reported in detector order, so results do not depend on the number of threads.",0, IntRange(0,1024));
+
 IntOption  Monosat::opt_bv_prop_skip(_cat_bv, "bv-theory-skip",
 		"Only process every nth bv theory propagation ('1' skips no propagations)",1, IntRange(1,INT32_MAX));
 
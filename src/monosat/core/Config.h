@@ -59,8 +59,11 @@ extern IntOption opt_eager_prop;
 extern IntOption opt_subsearch;
 
 extern BoolOption opt_remap_vars;
+extern BoolOption opt_async_output;
 extern BoolOption opt_decide_optimization_lits;
 extern IntOption opt_optimization_search_type;
+extern BoolOption opt_core_stratification;
+extern BoolOption opt_core_hardening;
 extern DoubleOption opt_rnd_optimization_freq;
 extern DoubleOption opt_rnd_optimization_restart_freq;
 extern BoolOption opt_amo_eager_prop;
@@ -93,6 +96,7 @@ extern StringOption opt_cycle_alg;
 extern IntOption opt_adaptive_history_clear;
 extern BoolOption opt_disable_history_clears;
 extern IntOption opt_dynamic_history_clear;
+extern BoolOption opt_graph_csr;
 extern BoolOption opt_lazy_backtrack;
 extern BoolOption opt_lazy_backtrack_decisions;
 extern IntOption opt_lazy_conflicts;
@@ -159,6 +163,7 @@ extern BoolOption opt_propagate_theories_during_simplification;
 extern BoolOption opt_propagate_theories_during_fast_simplification;
 extern BoolOption opt_shrink_theory_conflicts;
 extern BoolOption opt_early_theory_prop;
+extern BoolOption opt_theory_equivalences;
 extern IntOption opt_width;
 extern IntOption opt_height;
 extern IntOption opt_bits;
@@ -190,10 +195,12 @@ extern IntOption opt_maxflow_decisions_q;
 extern IntOption opt_maxflow_decision_paths;
 extern BoolOption opt_reach_detector_combined_maxflow;
 extern IntOption opt_adaptive_conflict_mincut;
+extern BoolOption opt_maxflow_reason_cache;
 extern BoolOption opt_shortest_path_prune_dist;
 extern BoolOption opt_graph_bv_prop;
 
 extern IntOption opt_graph_prop_skip;
+extern IntOption opt_graph_prop_threads;
 extern IntOption opt_bv_prop_skip;
 extern IntOption opt_fsm_prop_skip;
 
@@ -213,7 +220,7 @@ enum class PointInPolygonAlg {
 extern PointInPolygonAlg pipalg;
 
 enum class ReachAlg {
-	ALG_SAT, ALG_DFS, ALG_DIJKSTRA, ALG_DISTANCE, ALG_BFS, ALG_RAMAL_REPS
+	ALG_SAT, ALG_DFS, ALG_DIJKSTRA, ALG_DISTANCE, ALG_BFS, ALG_RAMAL_REPS, ALG_DYNAMIC
 };
 
 //For undirected reachability
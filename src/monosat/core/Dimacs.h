@@ -36,6 +36,7 @@
 #include <iostream>
 #include <cstdarg>
 #include "monosat/core/Remap.h"
+#include "monosat/core/BinaryGNF.h"
 namespace Monosat {
 
 
@@ -54,6 +55,10 @@ public:
 	}
 	virtual bool parseLine(B& in, Solver& S)=0;
 	virtual void implementConstraints(Solver & S)=0;
+	//Handle a block of n edges from a binary GNF file, equivalent to n 'edge' lines (edge variables are in DIMACS form, and weights may be null).
+	virtual bool parseEdges(int graphID, const int32_t * from, const int32_t * to, const int32_t * edgeVars, const int64_t * weights, int n, Solver& S){
+		return false;
+	}
 	const char * getParserName() const{
 		return parser_name;
 	}
@@ -240,6 +245,15 @@ private:
 		return false;
 	}
 	
+	bool parseEdges(int graphID, const int32_t * from, const int32_t * to, const int32_t * edgeVars, const int64_t * weights, int n, Solver& S) {
+		for (auto * p : parsers) {
+			if (p->parseEdges(graphID, from, to, edgeVars, weights, n, S)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
 	bool readLine(vec<char> & linebuf, B& in) {
 		linebuf.clear();
 		for (;;) {
@@ -257,11 +271,156 @@ private:
 		linebuf.push(0);
 		return true;
 	}
+	vec<Lit> tmp_lits;
 	int vars = 0;
 	int clauses = 0;
 	int clause_count=0;
 	int line_num=0;
 	int solves=0;
+	//Handle a (newline terminated) line that is not a clause or a comment. Returns true if the line was a solve statement.
+	bool parseStatement(char * line, Solver& S) {
+		char * b = line;
+		bool solve=false;
+		vec<Lit> & lits = tmp_lits;
+		if (match(b,"solve")){
+			int parsed_lit, var;
+			lits.clear();
+			for (;;) {
+				while(*b==' ')
+					++b;
+				if(*b=='\n')
+					break;
+				parsed_lit = parseInt(b);
+				if (parsed_lit == 0)
+					break;
+				var = abs(parsed_lit) - 1;
+				var = mapVar(S,var);
+				assumptions.push((parsed_lit > 0) ? mkLit(var) : ~mkLit(var));
+			}
+			solves++;
+			solve=true;
+		}else if (match(b,"clear_opt")) {
+			objectives.clear();
+		}else if (match(b,"minimize bv")){
+			//fprintf(stderr,"minimize statements not yet supported\n");
+			skipWhitespace(b);
+			int bvID = parseInt(b);
+			assert(bvID>=0);
+
+			objectives.push(Objective(bvID,false));
+		}else if (match(b,"maximize bv")){
+			//fprintf(stderr,"minimize statements not yet supported\n");
+			skipWhitespace(b);
+			int bvID = parseInt(b);
+			assert(bvID>=0);
+
+			objectives.push(Objective(bvID,true));
+		}else if (match(b,"maximize lits")){
+			//fprintf(stderr,"minimize statements not yet supported\n");
+			skipWhitespace(b);
+			objectives.push();
+			objectives.last().type = Objective::Type::PB;
+			objectives.last().maximize=true;
+			int n_lits = parseInt(b);
+			for (int i = 0;i<n_lits;i++) {
+				int parsed_lit = parseInt(b);
+				if(parsed_lit==0){
+					parse_errorf("Bad literal: 0\n");
+				}
+				Var var = abs(parsed_lit) - 1;
+				var = mapVar(S,var);
+				S.setFrozen(var,true);
+				objectives.last().pb_lits.push((parsed_lit > 0) ? mkLit(var) : ~mkLit(var));
+			}
+
+            for (int i = 0;i<n_lits;i++) {
+                skipWhitespaceNoNewLines(b);
+                if(*b=='\n')
+                    break;
+				int weight = parseInt(b);
+				objectives.last().pb_weights.push(weight);
+			}
+
+			if (objectives.last().pb_weights.size()>objectives.last().pb_lits.size()){
+				objectives.last().pb_weights.shrink(objectives.last().pb_weights.size()- objectives.last().pb_lits.size());
+			}
+			objectives.last().pb_weights.growTo(objectives.last().pb_lits.size(),1);
+		}else if (match(b,"minimize lits")){
+			//fprintf(stderr,"minimize statements not yet supported\n");
+			skipWhitespace(b);
+			objectives.push();
+			objectives.last().type = Objective::Type::PB;
+			objectives.last().maximize=false;
+			int n_lits = parseInt(b);
+			for (int i = 0;i<n_lits;i++) {
+				int parsed_lit = parseInt(b);
+				if(parsed_lit==0){
+					parse_errorf("Bad literal: 0\n");
+				}
+				Var var = abs(parsed_lit) - 1;
+				var = mapVar(S,var);
+				S.setFrozen(var,true);
+				objectives.last().pb_lits.push((parsed_lit > 0) ? mkLit(var) : ~mkLit(var));
+			}
+
+            for (int i = 0;i<n_lits;i++) {
+                skipWhitespaceNoNewLines(b);
+                if(*b=='\n')
+                    break;
+                int weight = parseInt(b);
+                objectives.last().pb_weights.push(weight);
+            }
+
+			if (objectives.last().pb_weights.size()>objectives.last().pb_lits.size()){
+				objectives.last().pb_weights.shrink(objectives.last().pb_weights.size()- objectives.last().pb_lits.size());
+			}
+			objectives.last().pb_weights.growTo(objectives.last().pb_lits.size(),1);
+		}else if (parseLine(b,line_num, S)) {
+			//do nothing
+		} else if (*line == 'p') {
+
+			if (eagerMatch(b, "p cnf")) {
+				vars = parseInt(b);
+				clauses = parseInt(b);
+			} else {
+				parse_errorf("Unexpected char: %c\n", *b);
+			}
+		}  else {
+			//if nothing else works, attempt to parse this line as a clause.
+			parse_errorf("Bad line at %d: %s",line_num,line);
+		}
+		return solve;
+	}
+
+	void implementConstraints(Solver& S) {
+		//Disabling this for now, as it is always triggered when there are theory atoms...
+		/*if (vars != S.nVars())
+			fprintf(stderr, "WARNING! DIMACS header mismatch: wrong number of variables.\n");
+		if (cnt != clauses)
+			fprintf(stderr, "WARNING! DIMACS header mismatch: wrong number of clauses.\n");*/
+		for (auto * p : parsers) {
+			try{
+				p->implementConstraints(S);
+			}catch(const std::exception & e){
+				std::cerr << e.what() << "\n";
+				std::cerr<<"PARSE ERROR in " << p->getParserName() << " parser.\n";
+				exit(1);
+			}catch(...){
+				std::cerr<<"PARSE ERROR in " << p->getParserName() << " parser.\n";
+				exit(1);
+			}
+		}
+		for(int i = 0;i<objectives.size();i++){
+			if(objectives[i].isBV()) {
+				int bvID = objectives[i].bvID;
+				bvID = this->mapBV(S, bvID);
+				objectives[i].bvID = bvID;
+			}else{
+                   //lits are already remapped
+                }
+		}
+	}
+
 	bool parse_(B& in, Solver& S) {
 		vec<Lit> lits;
 		if(opt_remap_vars){
@@ -292,114 +451,7 @@ private:
 				continue;//comment
 			}
 			readLine(linebuf, in);
-			char * b = linebuf.begin();
-			if (match(b,"solve")){
-				int parsed_lit, var;
-				lits.clear();
-				for (;;) {
-					while(*b==' ')
-						++b;
-					if(*b=='\n')
-						break;
-					parsed_lit = parseInt(b);
-					if (parsed_lit == 0)
-						break;
-					var = abs(parsed_lit) - 1;
-					var = mapVar(S,var);
-					assumptions.push((parsed_lit > 0) ? mkLit(var) : ~mkLit(var));
-				}
-				solves++;
-				solve=true;
-			}else if (match(b,"clear_opt")) {
-				objectives.clear();
-			}else if (match(b,"minimize bv")){
-				//fprintf(stderr,"minimize statements not yet supported\n");
-				skipWhitespace(b);
-				int bvID = parseInt(b);
-				assert(bvID>=0);
-
-				objectives.push(Objective(bvID,false));
-			}else if (match(b,"maximize bv")){
-				//fprintf(stderr,"minimize statements not yet supported\n");
-				skipWhitespace(b);
-				int bvID = parseInt(b);
-				assert(bvID>=0);
-
-				objectives.push(Objective(bvID,true));
-			}else if (match(b,"maximize lits")){
-				//fprintf(stderr,"minimize statements not yet supported\n");
-				skipWhitespace(b);
-				objectives.push();
-				objectives.last().type = Objective::Type::PB;
-				objectives.last().maximize=true;
-				int n_lits = parseInt(b);
-				for (int i = 0;i<n_lits;i++) {
-					int parsed_lit = parseInt(b);
-					if(parsed_lit==0){
-						parse_errorf("Bad literal: 0\n");
-					}
-					Var var = abs(parsed_lit) - 1;
-					var = mapVar(S,var);
-					S.setFrozen(var,true);
-					objectives.last().pb_lits.push((parsed_lit > 0) ? mkLit(var) : ~mkLit(var));
-				}
-
-                for (int i = 0;i<n_lits;i++) {
-                    skipWhitespaceNoNewLines(b);
-                    if(*b=='\n')
-                        break;
-					int weight = parseInt(b);
-					objectives.last().pb_weights.push(weight);
-				}
-
-				if (objectives.last().pb_weights.size()>objectives.last().pb_lits.size()){
-					objectives.last().pb_weights.shrink(objectives.last().pb_weights.size()- objectives.last().pb_lits.size());
-				}
-				objectives.last().pb_weights.growTo(objectives.last().pb_lits.size(),1);
-			}else if (match(b,"minimize lits")){
-				//fprintf(stderr,"minimize statements not yet supported\n");
-				skipWhitespace(b);
-				objectives.push();
-				objectives.last().type = Objective::Type::PB;
-				objectives.last().maximize=false;
-				int n_lits = parseInt(b);
-				for (int i = 0;i<n_lits;i++) {
-					int parsed_lit = parseInt(b);
-					if(parsed_lit==0){
-						parse_errorf("Bad literal: 0\n");
-					}
-					Var var = abs(parsed_lit) - 1;
-					var = mapVar(S,var);
-					S.setFrozen(var,true);
-					objectives.last().pb_lits.push((parsed_lit > 0) ? mkLit(var) : ~mkLit(var));
-				}
-
-                for (int i = 0;i<n_lits;i++) {
-                    skipWhitespaceNoNewLines(b);
-                    if(*b=='\n')
-                        break;
-                    int weight = parseInt(b);
-                    objectives.last().pb_weights.push(weight);
-                }
-
-				if (objectives.last().pb_weights.size()>objectives.last().pb_lits.size()){
-					objectives.last().pb_weights.shrink(objectives.last().pb_weights.size()- objectives.last().pb_lits.size());
-				}
-				objectives.last().pb_weights.growTo(objectives.last().pb_lits.size(),1);
-			}else if (parseLine(b,line_num, S)) {
-				//do nothing
-			} else if (linebuf[0] == 'p') {
-
-				if (eagerMatch(b, "p cnf")) {
-					vars = parseInt(b);
-					clauses = parseInt(b);
-				} else {
-					parse_errorf("Unexpected char: %c\n", *in);
-				}
-			}  else {
-				//if nothing else works, attempt to parse this line as a clause.
-				parse_errorf("Bad line at %d: %s",line_num,linebuf.begin());
-			}
+			solve = parseStatement(linebuf.begin(), S);
 		}
 		if(solve){
 			//continue reading any blank/comment lines
@@ -416,33 +468,7 @@ private:
 			}
 		}
 
-			//Disabling this for now, as it is always triggered when there are theory atoms...
-			/*if (vars != S.nVars())
-				fprintf(stderr, "WARNING! DIMACS header mismatch: wrong number of variables.\n");
-			if (cnt != clauses)
-				fprintf(stderr, "WARNING! DIMACS header mismatch: wrong number of clauses.\n");*/
-			for (auto * p : parsers) {
-				try{
-					p->implementConstraints(S);
-				}catch(const std::exception & e){
-					std::cerr << e.what() << "\n";
-					std::cerr<<"PARSE ERROR in " << p->getParserName() << " parser.\n";
-					exit(1);
-				}catch(...){
-					std::cerr<<"PARSE ERROR in " << p->getParserName() << " parser.\n";
-					exit(1);
-				}
-			}
-			for(int i = 0;i<objectives.size();i++){
-				if(objectives[i].isBV()) {
-					int bvID = objectives[i].bvID;
-					bvID = this->mapBV(S, bvID);
-					objectives[i].bvID = bvID;
-				}else{
-                   //lits are already remapped
-                }
-			}
-
+			implementConstraints(S);
 		}catch(const parse_error& e){
 			std::cerr << e.what() << "\n";
 			std::cerr<<"PARSE ERROR in DIMACS parser at line " << line_num << "\n";
@@ -457,6 +483,83 @@ private:
 		}
 		return solve;
 	}
+
+	bool parseBinary_(BinaryGNFReader& in, Solver& S) {
+		vec<Lit> lits;
+		if(opt_remap_vars){
+			S.setVarMap(this);
+		}
+		S.cancelUntil(0);
+		objectives.clear();
+		assumptions.clear();
+		bool solve=false;
+		BinaryGNFReader::Record r;
+		try{
+		while(!solve && in.next(r)){
+			line_num++;//for binary files, this counts records rather than lines
+			if(r.type==BinaryGNF::RECORD_CLAUSES){
+				BinaryGNF::ClausesHeader h;
+				memcpy(&h,r.payload,sizeof(h));
+				size_t n = h.count;
+				if(h.count<0 || sizeof(h) + n*sizeof(int32_t) > r.bytes){
+					parse_errorf("Bad clause record\n");
+				}
+				//the literals are read directly out of the file
+				const int32_t * data = (const int32_t*) (r.payload + sizeof(h));
+				lits.clear();
+				for(size_t i = 0;i<n;i++){
+					int parsed_lit = data[i];
+					if(parsed_lit==0){
+						clause_count++;
+						S.addClause_(lits);
+						lits.clear();
+					}else{
+						Var var = mapVar(S,abs(parsed_lit) - 1);
+						lits.push((parsed_lit > 0) ? mkLit(var) : ~mkLit(var));
+					}
+				}
+				if(lits.size()){
+					parse_errorf("Unterminated clause in clause record\n");
+				}
+			}else if(r.type==BinaryGNF::RECORD_EDGES){
+				BinaryGNF::EdgesHeader h;
+				memcpy(&h,r.payload,sizeof(h));
+				size_t n = h.count;
+				size_t int_bytes = BinaryGNF::padded(3*n*sizeof(int32_t));
+				if(h.count<0 || sizeof(h) + int_bytes + (h.weighted ? n*sizeof(int64_t):0) > r.bytes){
+					parse_errorf("Bad edge record\n");
+				}
+				const int32_t * from = (const int32_t*) (r.payload + sizeof(h));
+				const int32_t * to = from + n;
+				const int32_t * edgeVars = to + n;
+				const int64_t * weights = h.weighted ? (const int64_t*) (r.payload + sizeof(h) + int_bytes) : nullptr;
+				if(!parseEdges(h.graphID, from,to,edgeVars,weights,n,S)){
+					parse_errorf("No parser accepted a block of edges for graph %d\n",h.graphID);
+				}
+			}else if(r.type==BinaryGNF::RECORD_LINE){
+				if(r.bytes==0 || r.payload[r.bytes-1]!=0){
+					parse_errorf("Bad line record\n");
+				}
+				solve = parseStatement(r.payload, S);
+			}else{
+				parse_errorf("Unknown binary GNF record type %u\n",r.type);
+			}
+		}
+			implementConstraints(S);
+		}catch(const parse_error& e){
+			std::cerr << e.what() << "\n";
+			std::cerr<<"PARSE ERROR in binary GNF parser at record " << line_num << "\n";
+			exit(1);
+		}catch(const std::exception & e){
+			std::cerr << e.what() << "\n";
+			std::cerr<<"PARSE ERROR in binary GNF parser at record " << line_num << "\n";
+			exit(1);
+		}catch(...){
+			std::cerr<<"PARSE ERROR in binary GNF parser at record " << line_num << "\n";
+			exit(1);
+		}
+		return solve;
+	}
 public:
 	void addParser(Parser<char*, Solver> * parser) {
 		parser->setDimacs(this);
@@ -471,6 +574,10 @@ public:
 	bool parse(StreamBuffer & in, Solver& S) {
 		return parse_(in,S);
 	}
+	//Parse binary GNF (see BinaryGNF.h) up to and including the next solve statement, if any.
+	bool parse(BinaryGNFReader & in, Solver& S) {
+		return parseBinary_(in,S);
+	}
 };
 }
 ;
@@ -30,6 +30,7 @@
 #include <string>
 #include <cstdint>
 #include <limits>
+#include <atomic>
 namespace Monosat{
 
 namespace Optimization{
@@ -41,7 +42,8 @@ static rlim_t system_time_limit;
 static bool has_system_mem_limit=false;
 static rlim_t system_mem_limit;
 
-static Solver * solver;
+//the solver currently running under the optimization resource limits (which are process wide)
+static std::atomic<Solver*> solver(nullptr);
 
 static sighandler_t system_sigxcpu_handler = nullptr;
 
@@ -64,9 +66,9 @@ static initializer i;
 }
 void disableResourceLimits(Solver * S);
 static void SIGNAL_HANDLER_api(int signum) {
-	if(solver){
+	Solver * s = solver;
+	if(s){
 		fprintf(stderr,"Monosat resource limit reached\n");
-		Solver * s = solver;
 		disableResourceLimits(s);
 		s->interrupt();
 	}
@@ -74,9 +76,8 @@ static void SIGNAL_HANDLER_api(int signum) {
 
 
 void enableResourceLimits(Solver * S){
-	if(!solver){
-		assert(solver==nullptr);
-		solver=S;
+	Solver * expected=nullptr;
+	if(solver.compare_exchange_strong(expected,S)){
 
 		struct rusage ru;
 		getrusage(RUSAGE_SELF, &ru);
@@ -131,9 +132,8 @@ void enableResourceLimits(Solver * S){
 }
 
 void disableResourceLimits(Solver * S){
-	if(solver){
-
-		solver=nullptr;
+	Solver * expected=S;
+	if(solver.compare_exchange_strong(expected,nullptr)){
 		rlimit rl;
 		getrlimit(RLIMIT_CPU, &rl);
 		if(has_system_time_limit){
@@ -198,6 +198,42 @@ inline bool geq(int64_t lhs, int64_t rhs, bool invert){
 	}
 }
 
+int evalPB(SimpSolver & S,const Objective & o, bool over_approx, bool eval_at_level_0);
+
+//The objectives of the optimize_and_solve call running on this thread, used to report improved models to the callback.
+struct OptimizationProgress{
+	const vec<Objective> & objectives;
+	OptimizationCallback callback;
+	void * data;
+	int current=0;//the objective currently being optimized
+	vec<int64_t> values;
+	vec<int64_t> bounds;
+	OptimizationProgress(const vec<Objective> & objectives, OptimizationCallback callback, void * data):objectives(objectives),callback(callback),data(data){
+		values.growTo(objectives.size(),0);
+		bounds.growTo(objectives.size(),0);
+	}
+};
+static thread_local OptimizationProgress * progress=nullptr;
+
+//Called when the solver holds a model that improves on the best model so far;
+//bound is the best bound proven so far for the current objective.
+static void reportImprovedModel(SimpSolver & S, int64_t bound){
+	if(!progress || !progress->callback)
+		return;
+	const vec<Objective> & objectives = progress->objectives;
+	progress->bounds[progress->current]=bound;
+	for(int i = 0;i<objectives.size();i++){
+		//use the pessimistic approximation, in case any variables are unassigned
+		if(objectives[i].isBV()){
+			BVTheorySolver<int64_t> * bvTheory = (BVTheorySolver<int64_t>*) S.getBVTheory();
+			progress->values[i] = objectives[i].maximize ? bvTheory->getUnderApprox(objectives[i].bvID) : bvTheory->getOverApprox(objectives[i].bvID);
+		}else{
+			progress->values[i] = evalPB(S,objectives[i],!objectives[i].maximize,false);
+		}
+	}
+	progress->callback(progress->data,objectives.size(),progress->values,progress->bounds);
+}
+
 int64_t getApprox(Monosat::BVTheorySolver<int64_t> * bvTheory, int bvID,bool overApprox, bool level0=false){
 	if(overApprox){
 		return bvTheory->getOverApprox(bvID, level0);
@@ -325,6 +361,7 @@ int64_t optimize_linear_bv(Monosat::SimpSolver * S, Monosat::BVTheorySolver<int6
 				throw std::runtime_error("Error in optimization (minimum values are inconsistent with model)");
 			}
 			value=value2;
+			reportImprovedModel(*S,getApprox(bvTheory,bvID,invert,true));
 			if(opt_verb_optimize>=2){
 				printf("Found bv%d = %ld...\n",bvID,value);
 			}
@@ -508,6 +545,7 @@ int64_t optimize_linear_pb(Monosat::SimpSolver * S, PB::PBConstraintSolver * pbS
 				throw std::runtime_error("Error in optimization (minimum values are inconsistent with model)");
 			}
 			value = value2;
+			reportImprovedModel(*S,evalPB(*S,o,invert,true));
 
 
 
@@ -685,6 +723,7 @@ int64_t optimize_binary_pb(Monosat::SimpSolver * S,  PB::PBConstraintSolver * pb
 				min_val=new_value;
 				assert(geq(min_val, evalPB(*S, o, invert, true),invert));
 			}
+			reportImprovedModel(*S,min_val);
 //            if (old_dec_lit != lit_Undef) {
 //                discarded_pb_constraints.push(~old_dec_lit);
 //                //S->addClause(~old_dec_lit); //why isn't this safe? Because it might imply different values for intermediate variable assignments in the PB constraint, which were recorded in last_satisfying_assign
@@ -915,6 +954,7 @@ int64_t optimize_binary_bv(Monosat::SimpSolver * S, Monosat::BVTheorySolver<int6
 				min_val=new_value;
 				assert(gt(min_val,getApprox(bvTheory,bvID,invert,true),invert)); //assert(min_val>=bvTheory->getUnderApprox(bvID,true));
 			}
+			reportImprovedModel(*S,min_val);
 			if(opt_verb>=1 || opt_verb_optimize>=1){
 				printf("\rBest bv%d = %ld",bvID,max_val);
 			}
@@ -1145,6 +1185,7 @@ int64_t optimize_binary_restart_bv(Monosat::SimpSolver * S, Monosat::BVTheorySol
 				min_val=new_value;
 				assert(gt(min_val,getApprox(bvTheory,bvID,invert,true),invert)); //assert(min_val>=bvTheory->getUnderApprox(bvID,true));
 			}
+			reportImprovedModel(*S,min_val);
 			if(opt_verb>=1 || opt_verb_optimize>=1){
 				printf("\rBest bv%d = %ld",bvID,max_val);
 			}
@@ -1255,6 +1296,249 @@ int64_t optimize_binary_restart_bv(Monosat::SimpSolver * S, Monosat::BVTheorySol
 
 	return max_val;
 }
+void copyModel(SimpSolver & S, vec<Lit> & dest);
+
+/**
+ * Core-guided (OLL-style) optimization of a PB objective, using the unsatisfiable cores that the solver
+ * reports over its assumptions (via analyzeFinal).
+ *
+ * The objective is normalized into 'soft' literals, each of which costs its weight if it is false.
+ * All soft literals are assumed true; each core found this way raises the lower bound on the cost by
+ * the smallest weight in the core, which is then subtracted from every soft literal in the core,
+ * and replaced by a new soft literal enforcing (through a conditional PB constraint) that at most one of the core's
+ * literals is false (or, for a core containing such a constraint, that at most one more of its literals is false).
+ *
+ * With stratification, only soft literals of weight >= a threshold are assumed at first, lowering the threshold
+ * each time the solver finds a model, so that the heavy literals are dealt with first.
+ * With hardening, soft literals that are heavier than the gap between the best model and the lower bound are always assumed.
+ *
+ * Each satisfying assignment found along the way is an upper bound, so the search can be stopped at any time.
+ */
+int64_t optimize_core_guided_pb(Monosat::SimpSolver * S, PB::PBConstraintSolver * pbSolver, bool invert, const vec<Lit> & assumes, const Objective & o, bool & hit_cutoff, int64_t & n_solves, bool & found_model){
+	hit_cutoff=false;
+	double start_time = cpuTime();
+	struct Soft{
+		Lit lit;
+		int64_t weight;
+		int card;//if >=0, this literal enforces that at most 'bound' of the literals of cards[card] are false
+		int bound;
+		bool hardened;
+	};
+	vec<Soft> softs;
+	vec<vec<Lit>> cards;
+	vec<int> soft_of;//maps variables to soft literals
+	vec<int> core;
+	vec<Lit> assume;
+	vec<Lit> card_lits;
+	vec<int> card_weights;
+
+	//minimize cost = sign * objective, as offset + the sum of the weights of the false soft literals.
+	int64_t offset = 0;
+	for(int i = 0;i<o.pb_lits.size();i++){
+		int64_t c = i < o.pb_weights.size() ? o.pb_weights[i] : 1;
+		if(invert)
+			c=-c;
+		Lit l = o.pb_lits[i];
+		if(l==lit_Undef || c==0)
+			continue;
+		if(c>0){
+			softs.push({~l,c,-1,0,false});
+		}else{
+			offset+=c;
+			softs.push({l,-c,-1,0,false});
+		}
+	}
+	auto cost = [&](int64_t value){
+		return (invert ? -value : value) - offset;
+	};
+	auto objective = [&](int64_t c){
+		return invert ? -(c + offset) : c + offset;
+	};
+
+	int64_t lower_bound=0;//on the cost
+	int64_t best_value=0;//of the objective
+	bool have_best=false;
+	vec<Lit> best_model;
+	bool solver_has_best=false;//true if the solver is still in the state of the best model
+	if(found_model){
+		best_value = evalPB(*S, o, !invert);
+		have_best=true;
+		solver_has_best=true;
+		copyModel(*S,best_model);
+	}
+	int64_t n_cores=0;
+	int64_t total_core_size=0;
+	int n_strata=1;
+	int n_hardened=0;
+	auto report = [&](){
+		if(opt_verb_optimize>=1){
+			if(have_best) {
+				printf("Core-guided: %s bound %ld, best %ld (%ld cores, %ld solves, %f s)\n", invert ? "upper" : "lower",
+					   objective(lower_bound), best_value, n_cores, n_solves, cpuTime() - start_time);
+			}else{
+				printf("Core-guided: %s bound %ld, no model yet (%ld cores, %ld solves, %f s)\n", invert ? "upper" : "lower",
+					   objective(lower_bound), n_cores, n_solves, cpuTime() - start_time);
+			}
+			fflush(stdout);
+		}
+	};
+
+	auto nextThreshold = [&](int64_t below){
+		int64_t t=0;
+		for(Soft & s:softs){
+			if(s.weight>0 && !s.hardened && s.weight<below && s.weight>t)
+				t=s.weight;
+		}
+		return t;
+	};
+	int64_t threshold = opt_core_stratification ? nextThreshold(INT64_MAX) : 1;
+	if(threshold<=0)
+		threshold=1;
+
+	while(!hit_cutoff){
+		if(have_best && cost(best_value)<=lower_bound)
+			break;//optimal
+		for(Lit a:assume){
+			if(var(a)<soft_of.size())
+				soft_of[var(a)]=-1;
+		}
+		assume.clear();
+		for(Lit l:assumes)
+			assume.push(l);
+		for(int i = 0;i<softs.size();i++){
+			Soft & s = softs[i];
+			if(s.weight>0 && (s.weight>=threshold || s.hardened)){
+				assume.push(s.lit);
+				soft_of.growTo(var(s.lit)+1,-1);
+				soft_of[var(s.lit)]=i;
+			}
+		}
+		{
+			int conflict_limit = S->getConflictBudget();
+			if(conflict_limit<0)
+				conflict_limit=INT32_MAX;
+			int opt_lim = opt_limit_optimization_conflicts;
+			if(opt_lim<=0)
+				opt_lim=INT32_MAX;
+			int limit = std::min(opt_lim,conflict_limit);
+			if(limit>= INT32_MAX){
+				limit=-1;//disable limit.
+			}
+			S->setConfBudget(limit);
+		}
+		n_solves++;
+		Optimization::enableResourceLimits(S);
+		lbool res = S->solveLimited(assume,false,false);
+		Optimization::disableResourceLimits(S);
+		solver_has_best=false;
+		if(res==l_Undef){
+			hit_cutoff=true;
+			if(opt_verb>0){
+				printf("\nBudget exceeded during optimization, quiting early (model might not be optimal!)\n");
+			}
+			break;
+		}else if (res==l_True){
+			found_model=true;
+			int64_t value = evalPB(*S, o, !invert);
+			if(!have_best || lt(value,best_value,invert)){
+				best_value=value;
+				have_best=true;
+				solver_has_best=true;
+				copyModel(*S,best_model);
+				reportImprovedModel(*S,objective(lower_bound));
+				report();
+			}
+			if(opt_core_hardening){
+				int64_t gap = cost(best_value)-lower_bound;
+				for(Soft & s:softs){
+					if(s.weight>gap && !s.hardened){
+						s.hardened=true;
+						n_hardened++;
+					}
+				}
+			}
+			int64_t t = nextThreshold(threshold);
+			if(t<=0){
+				//all soft literals were assumed, so this model is optimal
+				break;
+			}
+			threshold=t;
+			n_strata++;
+		}else{
+			core.clear();
+			int64_t min_weight = INT64_MAX;
+			for(int i = 0;i<S->conflict.size();i++){
+				Lit a = ~S->conflict[i];
+				if(var(a)<soft_of.size() && soft_of[var(a)]>=0 && softs[soft_of[var(a)]].lit==a){
+					int si = soft_of[var(a)];
+					core.push(si);
+					min_weight = std::min(min_weight,softs[si].weight);
+				}
+			}
+			if(core.size()==0){
+				//the assumptions (or the instance) are unsatisfiable.
+				break;
+			}
+			n_cores++;
+			total_core_size+=core.size();
+			lower_bound+=min_weight;
+			for(int si:core){
+				softs[si].weight-=min_weight;
+			}
+			//relax the core: allow one more of its literals to be false, at a cost of min_weight
+			int n_core = core.size();
+			for(int j = 0;j<n_core;j++){
+				Soft s = softs[core[j]];
+				if(s.card>=0 && s.bound+1<cards[s.card].size()){
+					card_lits.clear();
+					card_weights.clear();
+					for(Lit l:cards[s.card]){
+						card_lits.push(~l);
+						card_weights.push(1);
+					}
+					Lit d = pbSolver->addConditionalConstr(card_lits,card_weights,s.bound+1,PB::Ineq::LEQ);
+					softs.push({d,min_weight,s.card,s.bound+1,false});
+				}
+			}
+			if(n_core>1){
+				cards.push();
+				card_lits.clear();
+				card_weights.clear();
+				for(int si:core){
+					cards.last().push(softs[si].lit);
+					card_lits.push(~softs[si].lit);
+					card_weights.push(1);
+				}
+				Lit d = pbSolver->addConditionalConstr(card_lits,card_weights,1,PB::Ineq::LEQ);
+				softs.push({d,min_weight,cards.size()-1,1,false});
+			}
+			if(opt_verb_optimize>=2){
+				printf("Core of size %d, weight %ld\n",n_core,min_weight);
+			}
+			report();
+		}
+	}
+	if(opt_verb>=1 || opt_verb_optimize>=1){
+		printf("Core-guided optimization: %ld cores (average size %.1f), %d strata, %d hardened, %ld solves, %f s\n", n_cores,
+			   n_cores ? ((double)total_core_size)/n_cores : 0.0, n_strata, n_hardened, n_solves, cpuTime() - start_time);
+	}
+	if(!have_best){
+		return evalPB(*S, o, !invert);
+	}
+	if(!solver_has_best){
+		//set the solver back to the best model (which also resets its decision phases, so that the caller can quickly find it again)
+		S->cancelUntil(0);
+		if(!S->solve(best_model, false, false)){
+			throw std::runtime_error("Error in optimization (instance has become unsat)");
+		}
+	}
+	if(!hit_cutoff && cost(best_value)>lower_bound){
+		//the cores did not close the gap (this should not happen); finish with a linear search from the best model
+		S->cancelUntil(0);
+		return optimize_linear_pb(S,pbSolver,invert,assumes,o,hit_cutoff,n_solves,found_model);
+	}
+	return best_value;
+}
 void copyModel(SimpSolver & S, vec<Lit> & dest){
 	dest.clear();
 	for(Var v = 0;v<S.nVars();v++){
@@ -1276,15 +1560,26 @@ void resetDecisionPriority(SimpSolver & S,vec<std::pair<Var, int>> & decision_va
 	}
 	decision_vars.clear();
 }
-lbool optimize_and_solve(SimpSolver & S,const vec<Lit> & assumes,const vec<Objective> & objectives,bool do_simp,  bool & found_optimal){
+lbool optimize_and_solve(SimpSolver & S,const vec<Lit> & assumes,const vec<Objective> & objectives,bool do_simp,  bool & found_optimal,
+		OptimizationCallback callback, void * callback_data){
+	OptimizationProgress state(objectives,callback,callback_data);
+	struct ProgressScope{
+		OptimizationProgress * previous;
+		ProgressScope(OptimizationProgress * state):previous(progress){
+			progress=state;
+		}
+		~ProgressScope(){
+			progress=previous;
+		}
+	} progress_scope(&state);
 	vec<Lit> best_model;
 	vec<Lit> assume;
 	vec<int64_t> model_vals;
 	for(Lit l:assumes)
 		assume.push(l);
-	static int solve_runs=0;
+	static std::atomic<int> n_solve_runs(0);
+	int solve_runs = ++n_solve_runs;
 	found_optimal=true;
-	solve_runs++;
 	if(opt_verb>=1 || opt_verb_optimize>=1){
 		if(solve_runs>1){
 			printf("Solving(%d)...\n",solve_runs);
@@ -1362,6 +1657,7 @@ lbool optimize_and_solve(SimpSolver & S,const vec<Lit> & assumes,const vec<Objec
 				r = true;
 				ever_solved=true;
 				copyModel(S,best_model);
+				//the model is reported to the callback below, once the bounds are known
 			} else if (res == l_False) {
 				r = false;
 			} else {
@@ -1411,9 +1707,23 @@ lbool optimize_and_solve(SimpSolver & S,const vec<Lit> & assumes,const vec<Objec
 			}
 
 
+			for(int i = 0;i<objectives.size();i++){
+				//at this point, max_values holds the best value each objective could possibly take
+				state.bounds[i]=max_values[i];
+			}
+			if(ever_solved){
+				reportImprovedModel(S,state.bounds[0]);
+			}
+
 			int64_t n_solves =  1;
 			bool hit_cutoff=false;
 			for (int i = 0;i<objectives.size() && !hit_cutoff;i++){
+				if(S.stopRequested()){
+					//the remaining objectives are left unoptimized, keeping the best model found so far
+					found_optimal=false;
+					break;
+				}
+				state.current=i;
 				if(objectives[i].isBV()) {
 					int bvID = objectives[i].bvID;
 
@@ -1423,7 +1733,9 @@ lbool optimize_and_solve(SimpSolver & S,const vec<Lit> & assumes,const vec<Objec
 					int64_t val=0;
 					if (opt_optimization_search_type==1) {
 						val = optimize_linear_bv(&S, bvTheory,objectives[i].maximize, assume, bvID, hit_cutoff, n_solves, ever_solved);
-					} else if (opt_optimization_search_type==0) {
+					} else if (opt_optimization_search_type==0 || opt_optimization_search_type==3) {
+						//core-guided search only applies to PB objectives
+
 						val = optimize_binary_bv(&S, bvTheory, objectives[i].maximize,assume, bvID, hit_cutoff, n_solves, ever_solved);
 					}else if (opt_optimization_search_type==2) {
 						val = optimize_binary_restart_bv(&S, bvTheory, objectives[i].maximize,assume, bvID, hit_cutoff, n_solves, ever_solved);
@@ -1440,6 +1752,8 @@ lbool optimize_and_solve(SimpSolver & S,const vec<Lit> & assumes,const vec<Objec
 					}
 					if (hit_cutoff) {
 						found_optimal = false;
+					}else{
+						state.bounds[i]=val;
 					}
 					if (opt_limit_optimization_time_per_arg)
 						hit_cutoff = false;//keep trying to minimize subsequent arguments
@@ -1471,6 +1785,8 @@ lbool optimize_and_solve(SimpSolver & S,const vec<Lit> & assumes,const vec<Objec
 						val = optimize_binary_pb(&S, pbSolver,objectives[i].maximize, assume,  objectives[i], hit_cutoff, n_solves, ever_solved);
 					}else if (opt_optimization_search_type==2) {
 						val = optimize_binary_pb(&S, pbSolver,objectives[i].maximize, assume,  objectives[i], hit_cutoff, n_solves, ever_solved);
+					}else if (opt_optimization_search_type==3) {
+						val = optimize_core_guided_pb(&S, pbSolver,objectives[i].maximize, assume,  objectives[i], hit_cutoff, n_solves, ever_solved);
 					}else{
 						throw std::runtime_error("Unknown optimization type");
 					}
@@ -1485,6 +1801,8 @@ lbool optimize_and_solve(SimpSolver & S,const vec<Lit> & assumes,const vec<Objec
 
 					if (hit_cutoff) {
 						found_optimal = false;
+					}else{
+						state.bounds[i]=val;
 					}
 
 					if (opt_limit_optimization_time_per_arg)
@@ -92,10 +92,18 @@ struct Objective{
     }
 };
 
+//Anytime optimization: called each time the optimizer finds a model that improves on the best model found so far
+//(the model is in the solver while the callback runs).
+//values[i] is the value of objective i in that model; bounds[i] is the best bound proven so far for objective i
+//(a lower bound when minimizing, an upper bound when maximizing), given the values of the preceding objectives.
+typedef void (*OptimizationCallback)(void * data, int n_objectives, const int64_t * values, const int64_t * bounds);
+
 int64_t optimize_linear(Monosat::SimpSolver * S, Monosat::BVTheorySolver<int64_t> * bvTheory,const vec<Lit> & assume,int bvID, bool & hit_cutoff, int64_t & n_solves);
 
 int64_t optimize_binary(Monosat::SimpSolver * S, Monosat::BVTheorySolver<int64_t> * bvTheory,const vec<Lit> & assume,int bvID, bool & hit_cutoff, int64_t & n_solves);
 
-lbool optimize_and_solve(Monosat::SimpSolver & S,const vec<Lit> & assume,const vec<Objective> & objectives, bool do_simp, bool & found_optimal);
+//If S.requestStop() is called during optimization, optimization ends early, keeping the best model found so far.
+lbool optimize_and_solve(Monosat::SimpSolver & S,const vec<Lit> & assume,const vec<Objective> & objectives, bool do_simp, bool & found_optimal,
+		OptimizationCallback callback=nullptr, void * callback_data=nullptr);
 };
 #endif /* OPTIMIZE_H_ */
@@ -83,6 +83,19 @@ Solver::~Solver() {
 // Creates a new SAT variable in the solver. If 'decision' is cleared, variable will not be
 // used as a decision variable (NOTE! This has effects on the meaning of a SATISFIABLE result).
 //
+void Solver::reserveVars(int n) {
+	int sz = nVars() + n;
+	assigns.capacity(sz);
+	vardata.capacity(sz);
+	priority.capacity(sz);
+	theory_vars.capacity(sz);
+	activity.capacity(sz);
+	seen.capacity(sz);
+	polarity.capacity(sz);
+	decision.capacity(sz);
+	trail.capacity(sz);
+}
+
 Var Solver::newVar(bool sign, bool dvar) {
 
 	int v;
@@ -1235,6 +1248,119 @@ void Solver::rebuildTheoryOrderHeap() {
 		}
 	}
 }
+/*_________________________________________________________________________________________________
+ |
+ |  findEquivalentLits : [void]  ->  [bool]
+ |
+ |  Description:
+ |    Detect literals that are equivalent through the (original and learnt) binary clauses that are unassigned at
+ |    level 0, as the strongly connected components of the binary implication graph. Each literal is mapped to the
+ |    literal of lowest variable in its component (see getEquivalentLit()); no clauses are changed.
+ |    Returns false (and leaves every literal as its own representative) if some variable is equivalent to its
+ |    own negation.
+ |________________________________________________________________________________________________@*/
+bool Solver::findEquivalentLits() {
+	assert(decisionLevel() == 0);
+	equivalent_lits.clear();
+	int n = nVars() * 2;
+	//build the implication graph in compressed sparse row form: each binary clause (a b) implies both ~a->b and ~b->a.
+	vec<Lit> binaries;
+	for (int k = 0; k < 2; k++) {
+		vec<CRef>& cs = k == 0 ? clauses : learnts;
+		for (CRef cr : cs) {
+			const Clause& c = ca[cr];
+			if (c.size() == 2 && !c.mark() && value(c[0]) == l_Undef && value(c[1]) == l_Undef) {
+				binaries.push(c[0]);
+				binaries.push(c[1]);
+			}
+		}
+	}
+	if (binaries.size() == 0)
+		return true;
+	vec<int> start;
+	start.growTo(n + 1, 0);
+	for (Lit l : binaries)
+		start[toInt(~l) + 1]++;
+	for (int i = 0; i < n; i++)
+		start[i + 1] += start[i];
+	vec<int> next;
+	start.copyTo(next);
+	vec<Lit> implied;
+	implied.growTo(binaries.size());
+	for (int i = 0; i < binaries.size(); i += 2) {
+		implied[next[toInt(~binaries[i])]++] = binaries[i + 1];
+		implied[next[toInt(~binaries[i + 1])]++] = binaries[i];
+	}
+
+	//iterative Tarjan; 'next' is reused as the position of the next unexplored edge of each literal
+	vec<int> index;
+	vec<int> low;
+	vec<int> component;
+	index.growTo(n, -1);
+	low.growTo(n, 0);
+	component.growTo(n, -1);
+	vec<int> stack;
+	vec<int> call_stack;
+	int n_index = 0;
+	int n_components = 0;
+	equivalent_lits.growTo(nVars());
+	for (Var v = 0; v < nVars(); v++)
+		equivalent_lits[v] = mkLit(v);
+
+	for (int root = 0; root < n; root++) {
+		if (index[root] >= 0 || start[root] == start[root + 1])
+			continue;
+		call_stack.push(root);
+		while (call_stack.size()) {
+			int u = call_stack.last();
+			if (index[u] < 0) {
+				index[u] = low[u] = n_index++;
+				next[u] = start[u];
+				stack.push(u);
+			}
+			bool descended = false;
+			while (next[u] < start[u + 1]) {
+				int w = toInt(implied[next[u]++]);
+				if (index[w] < 0) {
+					call_stack.push(w);
+					descended = true;
+					break;
+				} else if (component[w] < 0 && index[w] < low[u]) {
+					low[u] = index[w];
+				}
+			}
+			if (descended)
+				continue;
+			call_stack.pop();
+			if (call_stack.size() && low[u] < low[call_stack.last()])
+				low[call_stack.last()] = low[u];
+			if (low[u] == index[u]) {
+				//pop the component; its representative is its literal of lowest variable
+				int first = stack.size();
+				int rep = u;
+				do {
+					first--;
+					if (stack[first] < rep)
+						rep = stack[first];
+				} while (stack[first] != u);
+				for (int i = first; i < stack.size(); i++) {
+					Lit l = toLit(stack[i]);
+					if (component[toInt(~l)] == n_components) {
+						//l is equivalent to ~l
+						equivalent_lits.clear();
+						return false;
+					}
+					component[stack[i]] = n_components;
+					equivalent_lits[var(l)] = toLit(rep) ^ sign(l);
+				}
+				stack.shrink(stack.size() - first);
+				n_components++;
+			}
+		}
+	}
+	return true;
+}
+
 /*_________________________________________________________________________________________________
  |
  |  simplify : [void]  ->  [bool]
@@ -1736,6 +1862,8 @@ lbool Solver::search(int nof_conflicts) {
 			analyze(confl, learnt_clause, backtrack_level);
 
 			cancelUntil(backtrack_level);
+			if (clause_exchange)
+				clause_exchange->exportClause(learnt_clause);
 
 			//this is now slightly more complicated, if there are multiple lits implied by the super solver in the current decision level:
 			//The learnt clause may not be asserting.
@@ -1976,6 +2104,37 @@ lbool Solver::search(int nof_conflicts) {
 	return l_Undef;
 }
 
+//Add any learnt clauses that other portfolio workers have shared since the last restart.
+//Returns false if the solver is now in conflict at level 0.
+bool Solver::importSharedClauses() {
+	assert(decisionLevel() == 0);
+	clause_exchange->importClauses([&](vec<Lit> & ps) {
+		if (!ok)
+			return;
+		int i, j;
+		for (i = j = 0; i < ps.size(); i++) {
+			if (var(ps[i]) >= nVars())
+				return;
+			if (value(ps[i]) == l_True)
+				return;
+			else if (value(ps[i]) == l_Undef)
+				ps[j++] = ps[i];
+		}
+		ps.shrink(i - j);
+		if (ps.size() == 0) {
+			ok = false;
+		} else if (ps.size() == 1) {
+			uncheckedEnqueue(ps[0]);
+		} else {
+			CRef cr = ca.alloc(ps, true);
+			learnts.push(cr);
+			attachClause(cr);
+			claBumpActivity(ca[cr]);
+		}
+	});
+	return ok;
+}
+
 double Solver::progressEstimate() const {
 	double progress = 0;
 	double F = 1.0 / nVars();
@@ -2113,6 +2272,12 @@ lbool Solver::solve_() {
 			break;
 		}
 		curr_restarts++;
+		if (clause_exchange && status == l_Undef && !importSharedClauses()) {
+			status = l_False;
+		}
+		if (status == l_Undef && !inprocess()) {
+			status = l_False;
+		}
 		if (opt_rnd_restart && status == l_Undef) {
 
 			for (int i = 0; i < nVars(); i++) {
@@ -33,7 +33,9 @@
 #include "monosat/core/Theory.h"
 #include "monosat/core/TheorySolver.h"
 #include "monosat/core/Config.h"
+#include "monosat/core/ClauseExchange.h"
 #include <cinttypes>
+#include <atomic>
 
 //this is _really_ ugly...
 template<unsigned int D, class T> class GeometryTheorySolver;
@@ -69,6 +71,7 @@ public:
 	//
 	virtual Var newVar(bool polarity = true, bool dvar = true); // Add a new variable with parameters specifying variable mode.
 	virtual void    releaseVar(Lit l);                                  // Make literal true and promise to never refer to variable again.
+	void    reserveVars(int n);                                         // Reserve space for n more variables.
 
 	virtual bool addClause(const vec<Lit>& ps);                     // Add a clause to the solver.
 	virtual bool addEmptyClause();                             // Add the empty clause, making the solver contradictory.
@@ -177,7 +180,7 @@ public:
 		return markers.last();
 	}
 
-	void printStats(int detail_level = 0) {
+	virtual void printStats(int detail_level = 0) {
 
 		double cpu_time = cpuTime();
 		//double mem_used = memUsedPeak();
@@ -203,6 +206,10 @@ public:
 				   stats_pure_theory_lits, pure_literal_detections, stats_pure_lit_time);
 		}
 
+		if(clause_exchange){
+			printf("shared clauses        : %" PRId64 " exported, %" PRId64 " imported (%" PRId64 " dropped)\n", clause_exchange->stats_exported,
+				   clause_exchange->stats_imported, clause_exchange->stats_dropped);
+		}
 		if(opt_check_solution){
 			printf("Solution double-checking time (disable with -no-check-solution): %f s\n",stats_solution_checking_time);
 		}
@@ -305,11 +312,22 @@ public:
 	}
 
 	void preprocess(){
+		if(opt_theory_equivalences && theories.size() && findEquivalentLits()){
+			for(Theory *t:theories){
+				t->mergeEquivalentAtoms();
+			}
+		}
 		for(Theory *t:theories){
 			t->preprocess();
 		}
 	}
 
+	Lit getEquivalentLit(Lit l) override{
+		if(var(l) >= equivalent_lits.size())
+			return l;
+		return equivalent_lits[var(l)] ^ sign(l);
+	}
+
 	//Lazily construct a reason for a literal propagated from a theory
 	CRef constructReason(Lit p) {
 		static int iterp =0;
@@ -461,6 +479,9 @@ public:
 	void budgetOff();
 	void interrupt();          // Trigger a (potentially asynchronous) interruption of the solver.
 	void clearInterrupt();     // Clear interrupt indicator flag.
+	void requestStop();        // Thread-safe: stop limited searches until clearStop() is called (see stop_requested).
+	void clearStop();
+	bool stopRequested() const;
 
 	// Memory managment:
 	//
@@ -501,6 +522,7 @@ public:
 	Solver * S = nullptr;    							//super solver
 	Theory * bvtheory=nullptr;
 	PB::PBConstraintSolver * pbsolver = nullptr;
+	ClauseExchange * clause_exchange = nullptr;//if set, short learnt clauses are shared with other portfolio workers
 	bool initialPropagate = true;    				//to force propagation to occur at least once to the theory solvers
 	int super_qhead = 0;
 	int local_qhead = 0;
@@ -707,6 +729,7 @@ protected:
 	vec<Lit> add_tmp;
 
 	vec<vec<Lit>> clauses_to_add;
+	vec<Lit> equivalent_lits;//for each variable, the representative of its positive literal (see findEquivalentLits)
 
 	double max_learnts=1;
 	double learntsize_adjust_confl=0;
@@ -716,7 +739,12 @@ protected:
 	//
 	int64_t conflict_budget;    // -1 means no budget.
 	int64_t propagation_budget; // -1 means no budget.
-	bool asynch_interrupt=false;
+	std::atomic<bool> asynch_interrupt{false};
+	//Unlike asynch_interrupt, this is not cleared when the next search begins, so a caller that is between searches
+	//(such as the optimizer) will still see it. It only stops limited searches (solveLimited);
+	//searches without a budget (which restore a previously found model) are unaffected.
+	std::atomic<bool> stop_requested{false};
+	bool limited_search=false;
 
 	// Main internal methods:
 	//
@@ -749,6 +777,12 @@ public:
 	double & getRandomSeed()override{
 		return random_seed;
 	}
+	void setClauseExchange(ClauseExchange * exchange){
+		clause_exchange=exchange;
+	}
+	ClauseExchange * getClauseExchange(){
+		return clause_exchange;
+	}
 
 
 
@@ -856,6 +890,12 @@ protected:
 	bool satisfied(const Clause& c) const; // Returns TRUE if a clause is satisfied in the current state.
 
 	void relocAll(ClauseAllocator& to);
+	bool findEquivalentLits();                                 // Detect literals that are equivalent through binary clauses at level 0.
+	// Called at decision level 0 between restarts, to give subclasses a chance to simplify the clause database.
+	// Returns false if the instance has been found to be unsatisfiable.
+	virtual bool inprocess() {
+		return true;
+	}
 public:
 	// Misc:
 	//
@@ -882,6 +922,7 @@ private:
 	bool addConflictClause(vec<Lit> & theory_conflict, CRef & confl_out, bool permanent = false);
 
 	bool addDelayedClauses(CRef & conflict);
+	bool importSharedClauses();
 	// Static helpers:
 	//
 	inline void toSuper(const vec<Lit> & from, vec<Lit> & to) {
@@ -1163,11 +1204,20 @@ inline void Solver::interrupt() {
 inline void Solver::clearInterrupt() {
 	asynch_interrupt = false;
 }
+inline void Solver::requestStop() {
+	stop_requested = true;
+}
+inline void Solver::clearStop() {
+	stop_requested = false;
+}
+inline bool Solver::stopRequested() const {
+	return stop_requested;
+}
 inline void Solver::budgetOff() {
 	conflict_budget = propagation_budget = -1;
 }
 inline bool Solver::withinBudget() const {
-	return !asynch_interrupt && (conflict_budget < 0 || conflicts < (uint64_t) conflict_budget)
+	return !asynch_interrupt && !(limited_search && stop_requested) && (conflict_budget < 0 || conflicts < (uint64_t) conflict_budget)
 		   && (propagation_budget < 0 || propagations < (uint64_t) propagation_budget);
 }
 
@@ -1207,7 +1257,10 @@ inline bool Solver::solve(const vec<Lit>& assumps) {
 }
 inline lbool Solver::solveLimited(const vec<Lit>& assumps) {
 	assumps.copyTo(assumptions);
-	return solve_();
+	limited_search = true;
+	lbool val = solve_();
+	limited_search = false;
+	return val;
 }
 inline bool Solver::okay() const {
 	return ok;
@@ -106,6 +106,11 @@ public:
 	}
 	virtual void preprocess(){
 
+	}
+	//Called at level 0 before preprocess(), after the solver has detected which literals are equivalent through its
+	//binary clauses (see TheorySolver::getEquivalentLit), to give the theory a chance to merge equivalent atoms.
+	virtual void mergeEquivalentAtoms(){
+
 	}
 };
 
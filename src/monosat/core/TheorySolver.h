@@ -79,6 +79,11 @@ public:
 	virtual Lit unmap(Lit from){
 		return from;
 	}
+	//Returns the representative of the class of literals that the solver has proven to be equivalent to 'l' at level 0
+	//(or 'l' itself, if there are none).
+	virtual Lit getEquivalentLit(Lit l){
+		return l;
+	}
 };
 }
 ;
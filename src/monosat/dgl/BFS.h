@@ -212,11 +212,11 @@ public:
 			//if(!old_seen[u]){
 			//	changed.push_back(u);
 			//}
-			for (int i = 0; i < g.nIncident(u, undirected); i++) {
-				if (!g.edgeEnabled(g.incident(u, i, undirected).id))
+			for (auto & e : g.outEdges(u, undirected)) {
+				if (!g.edgeEnabled(e.id))
 					continue;
-				int v = g.incident(u, i, undirected).node;
-				int edgeID = g.incident(u, i, undirected).id;
+				int v = e.node;
+				int edgeID = e.id;
 				if (!seen[v]) {
 					seen[v] = 1;
 					prev[v] = edgeID;
@@ -259,11 +259,11 @@ public:
 			int u = check[i];
 			if (!seen[u]) {
 				if (!undirected) {
-					for (int i = 0; i < g.nIncoming(u); i++) {
+					for (auto & e : g.inEdges(u)) {
 						
-						if (g.edgeEnabled(g.incoming(u, i).id)) {
-							int from = g.incoming(u, i).node;
-							int edgeID = g.incoming(u, i).id;
+						if (g.edgeEnabled(e.id)) {
+							int from = e.node;
+							int edgeID = e.id;
 							int to = u;
 							if (seen[from]) {
 								
@@ -276,11 +276,11 @@ public:
 						}
 					}
 				} else {
-					for (int i = 0; i < g.nIncident(u, undirected); i++) {
+					for (auto & e : g.outEdges(u, undirected)) {
 						
-						if (g.edgeEnabled(g.incident(u, i, undirected).id)) {
-							int from = g.incident(u, i, undirected).node;
-							int edgeID = g.incident(u, i, undirected).id;
+						if (g.edgeEnabled(e.id)) {
+							int from = e.node;
+							int edgeID = e.id;
 							assert(from != u);
 							int to = u;
 							if (seen[from]) {
@@ -518,11 +518,11 @@ public:
 			if (reportPolarity == 1)
 				status.setReachable(u, true);
 			
-			for (int i = 0; i < g.nIncident(u, undirected); i++) {
-				if (!g.edgeEnabled(g.incident(u, i, undirected).id))
+			for (auto & e : g.outEdges(u, undirected)) {
+				if (!g.edgeEnabled(e.id))
 					continue;
-				int v = g.incident(u, i, undirected).node;
-				int edgeID = g.incident(u, i, undirected).id;
+				int v = e.node;
+				int edgeID = e.id;
 				if (!seen[v]) {
 					seen[v] = 1;
 					prev[v] = edgeID;
@@ -585,9 +585,9 @@ public:
 		}
 		
 		for (int i = 0; i < g.nodes(); i++) {
-			for (int j = 0; j < g.nIncident(i, undirected); j++) {
-				int id = g.incident(i, j, undirected).id;
-				int u = g.incident(i, j, undirected).node;
+			for (auto & e : g.outEdges(i, undirected)) {
+				int id = e.id;
+				int u = e.node;
 				const char * s = "black";
 				if (g.edgeEnabled(id))
 					s = "blue";
@@ -813,11 +813,11 @@ public:
 			if (reportPolarity >= 0)
 				status.setMininumDistance(u, true, dist[u]);
 			int d = dist[u];
-			for (int i = 0; i < g.nIncident(u, undirected); i++) {
-				if (!g.edgeEnabled(g.incident(u, i, undirected).id))
+			for (auto & e : g.outEdges(u, undirected)) {
+				if (!g.edgeEnabled(e.id))
 					continue;
-				int edgeID = g.incident(u, i, undirected).id;
-				int v = g.incident(u, i, undirected).node;
+				int edgeID = e.id;
+				int v = e.node;
 				int dv = dist[v];
 				int alt = d + 1;
 				if (alt > maxDistance)
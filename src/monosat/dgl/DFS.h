@@ -206,11 +206,11 @@ public:
 			//if(!old_seen[u]){
 			//	changed.push_back(u);
 			//}
-			for (int i = 0; i < g.nIncident(u, undirected); i++) {
-				if (!g.edgeEnabled(g.incident(u, i, undirected).id))
+			for (auto & e : g.outEdges(u, undirected)) {
+				if (!g.edgeEnabled(e.id))
 					continue;
-				int v = g.incident(u, i, undirected).node;
-				int edgeID = g.incident(u, i, undirected).id;
+				int v = e.node;
+				int edgeID = e.id;
 				if (!seen[v]) {
 					seen[v] = 1;
 					prev[v] = edgeID;
@@ -253,11 +253,11 @@ public:
 		for (int i = 0; i < check.size(); i++) {
 			int u = check[i];
 			if (!seen[u]) {
-				for (int i = 0; i < g.nIncoming(u, undirected); i++) {
-					if (g.edgeEnabled(g.incoming(u, i, undirected).id)) {
-						int from = g.incoming(u, i, undirected).node;
+				for (auto & e : g.inEdges(u, undirected)) {
+					if (g.edgeEnabled(e.id)) {
+						int from = e.node;
 						int to = u;
-						int edgeID = g.incoming(u, i, undirected).id;
+						int edgeID = e.id;
 						if (seen[from]) {
 							seen[to] = 1;
 							prev[to] = edgeID;
@@ -490,11 +490,11 @@ public:
 			if (reportPolarity == 1)
 				status.setReachable(u, true);
 			
-			for (int i = 0; i < g.nIncident(u, undirected); i++) {
-				if (!g.edgeEnabled(g.incident(u, i, undirected).id))
+			for (auto & e : g.outEdges(u, undirected)) {
+				if (!g.edgeEnabled(e.id))
 					continue;
-				int v = g.incident(u, i, undirected).node;
-				int edgeid = g.incident(u, i, undirected).id;
+				int v = e.node;
+				int edgeid = e.id;
 				if (!seen[v]) {
 					seen[v] = 1;
 					prev[v] = edgeid;
@@ -557,9 +557,9 @@ public:
 		}
 		
 		for (int i = 0; i < g.nodes(); i++) {
-			for (int j = 0; j < g.nIncident(i); j++) {
-				int id = g.incident(i, j).id;
-				int u = g.incident(i, j).node;
+			for (auto & e : g.outEdges(i)) {
+				int id = e.id;
+				int u = e.node;
 				const char * s = "black";
 				if (g.edgeEnabled(id))
 					s = "blue";
@@ -191,11 +191,11 @@ public:
 			 changed.push_back(u);
 			 }*/
 			q.removeMin();
-			for (int i = 0; i < g.nIncident(u, undirected); i++) {
-				if (!g.edgeEnabled(g.incident(u, i, undirected).id))
+			for (auto & e : g.outEdges(u, undirected)) {
+				if (!g.edgeEnabled(e.id))
 					continue;
-				int edgeID = g.incident(u, i, undirected).id;
-				int v = g.incident(u, i, undirected).node;
+				int edgeID = e.id;
+				int v = e.node;
 				Weight alt = dist[u] +  g.getWeight(edgeID);
 				if (alt < dist[v]) {
 					dist[v] = alt;
@@ -479,11 +479,11 @@ public:
 			 changed.push_back(u);
 			 }*/
 			q.removeMin();
-			for (int i = 0; i < g.nIncident(u, undirected); i++) {
-				if (!g.edgeEnabled(g.incident(u, i, undirected).id))
+			for (auto & e : g.outEdges(u, undirected)) {
+				if (!g.edgeEnabled(e.id))
 					continue;
-				int edgeID = g.incident(u, i, undirected).id;
-				int v = g.incident(u, i, undirected).node;
+				int edgeID = e.id;
+				int v = e.node;
 				int alt = dist[u] + 1;
 				if (alt < dist[v]) {
 					dist[v] = alt;
@@ -156,21 +156,21 @@ public:
 		//Build the level graph using a simple BFS
 		for (int i = 0; i < Q.size(); i++) {
 			int u = Q[i];
-			for (int j = 0; j < g.nIncident(u); j++) {
-				int edgeID = g.incident(u, j).id;
+			for (auto & e : g.outEdges(u)) {
+				int edgeID = e.id;
 				if (!g.edgeEnabled(edgeID))
 					continue;
-				int v = g.incident(u, j).node;
+				int v = e.node;
 				if (dist[v] < 0 && F[edgeID] < g.getWeight(edgeID)) {
 					dist[v] = dist[u] + 1;
 					Q.push_back(v);
 				}
 			}
-			for (int j = 0; j < g.nIncoming(u); j++) {
-				int edgeID = g.incoming(u, j).id;
+			for (auto & e : g.inEdges(u)) {
+				int edgeID = e.id;
 				if (!g.edgeEnabled(edgeID))
 					continue;
-				int v = g.incoming(u, j).node;
+				int v = e.node;
 				//this is a backward edge, so it has capacity exactly if the forward edge has flow
 				if (dist[v] < 0 && F[edgeID]>0) {
 					dist[v] = dist[u] + 1;
@@ -193,12 +193,13 @@ public:
 			if (u == dst)
 				return M[u];
 			bool found = false;
-			for (; pos[u] < g.nIncident(u); pos[u]++) {
+			auto out = g.outEdges(u);
+			for (; pos[u] < out.size(); pos[u]++) {
 				//int edgeID = g.adjacency[u][pos[u]].id;
-				int edgeID = g.incident(u, pos[u]).id;
+				int edgeID = out[pos[u]].id;
 				if (!g.edgeEnabled(edgeID))
 					continue;
-				int v = g.incident(u, pos[u]).node;
+				int v = out[pos[u]].node;
 				if (dist[v] == dist[u] + 1 && F[edgeID] < g.getWeight(edgeID)) {
 					//printf("%d\n",edgeID);
 					found = true;
@@ -225,12 +226,13 @@ public:
 				}
 			}
 			if (!found) {
-				for (; pos[u] - g.nIncident(u) < g.nIncoming(u); pos[u]++) {
+				auto in = g.inEdges(u);
+				for (; pos[u] - out.size() < in.size(); pos[u]++) {
 					//int edgeID = g.inverted_adjacency[u][pos[u]-g.nIncident(u)].id;
-					int edgeID = g.incoming(u, pos[u] - g.nIncident(u)).id;
+					int edgeID = in[pos[u] - out.size()].id;
 					if (!g.edgeEnabled(edgeID))
 						continue;
-					int v = g.incoming(u, pos[u] - g.nIncident(u)).node;
+					int v = in[pos[u] - out.size()].node;
 					//these are backwards edges, which have capacity exactly if the forward edge has non-zero flow
 					if (dist[v] == dist[u] + 1 && F[edgeID]>0) {
 						//printf("-%d\n",edgeID);
@@ -313,12 +315,14 @@ public:
 		if (u == dst)
 			return f;
 		
-		for (; pos[u] < g.nIncident(u); pos[u]++) {
+		auto out = g.outEdges(u);
+		auto in = g.inEdges(u);
+		for (; pos[u] < out.size(); pos[u]++) {
 			//int edgeID = g.adjacency[u][pos[u]].id;
-			int edgeID = g.incident(u, pos[u]).id;
+			int edgeID = out[pos[u]].id;
 			if (!g.edgeEnabled(edgeID))
 				continue;
-			int v = g.incident(u, pos[u]).node;
+			int v = out[pos[u]].node;
 			if (dist[v] == dist[u] + 1 && F[edgeID] < g.getWeight(edgeID)) {
 				//printf("%d\n",edgeID);
 				Weight c = g.getWeight(edgeID) - F[edgeID];
@@ -330,12 +334,12 @@ public:
 			}
 		}
 		
-		for (; pos[u] - g.nIncident(u) < g.nIncoming(u); pos[u]++) {
+		for (; pos[u] - out.size() < in.size(); pos[u]++) {
 			//int edgeID = g.inverted_adjacency[u][pos[u]-g.nIncident(u)].id;
-			int edgeID = g.incoming(u, pos[u] - g.nIncident(u)).id;
+			int edgeID = in[pos[u] - out.size()].id;
 			if (!g.edgeEnabled(edgeID))
 				continue;
-			int v = g.incoming(u, pos[u] - g.nIncident(u)).node;
+			int v = in[pos[u] - out.size()].node;
 			//these are backwards edges, which have capacity exactly if the forward edge has non-zero flow
 			if (dist[v] == dist[u] + 1 && F[edgeID]>0) {
 				//printf("-%d\n",edgeID);
@@ -475,11 +479,11 @@ public:
 		for (int j = 0; j < Q.size(); j++) {
 			int u = Q[j];
 			
-			for (int i = 0; i < g.nIncident(u); i++) {
-				if (!g.edgeEnabled(g.incident(u, i).id))
+			for (auto & e : g.outEdges(u)) {
+				if (!g.edgeEnabled(e.id))
 					continue;
-				int v = g.incident(u, i).node;
-				int id = g.incident(u, i).id;
+				int v = e.node;
+				int id = e.id;
 				if (g.getWeight(id) - F[id] == 0) {
 					cut.push_back(MaxFlowEdge { u, v, id });    	//potential element of the cut
 				} else if (!seen[v]) {
@@ -487,11 +491,11 @@ public:
 					seen[v] = true;
 				}
 			}
-			for (int i = 0; i < g.nIncoming(u); i++) {
-				if (!g.edgeEnabled(g.incoming(u, i).id))
+			for (auto & e : g.inEdges(u)) {
+				if (!g.edgeEnabled(e.id))
 					continue;
-				int v = g.incoming(u, i).node;
-				int id = g.incoming(u, i).id;
+				int v = e.node;
+				int id = e.id;
 				if (F[id] == 0) {
 					
 				} else if (!seen[v]) {
@@ -54,7 +54,8 @@ public:
 template<typename Weight>
 class DynamicGraph {
 	
-	std::vector<bool> edge_status;
+	//One byte per edge (rather than std::vector<bool>), so that the hot loops of the algorithms can test edges without bit masking.
+	std::vector<char> edge_status;
 	std::vector<bool> edge_status_const;
 	std::vector<Weight> weights;
 	int num_nodes=0;
@@ -86,6 +87,54 @@ public:
 	std::vector<std::vector<Edge> > adjacency_list;
 	std::vector<std::vector<Edge> > inverted_adjacency_list;
 	std::vector<std::vector<Edge> > adjacency_undirected_list;
+
+	/**
+	 * A contiguous range of the edges incident to a node, as returned by outEdges() and inEdges().
+	 * The range is invalidated if nodes or edges are added to the graph.
+	 */
+	struct EdgeRange {
+		const Edge * first;
+		const Edge * last;
+		const Edge * begin() const {
+			return first;
+		}
+		const Edge * end() const {
+			return last;
+		}
+		int size() const {
+			return last - first;
+		}
+		const Edge & operator[](int i) const {
+			assert(i >= 0 && i < size());
+			return first[i];
+		}
+	};
+
+	//If true, outEdges() and inEdges() read from a compressed sparse row snapshot of the adjacency lists,
+	//which keeps the edges of consecutive nodes adjacent in memory.
+	bool use_csr = true;
+private:
+	//Compressed sparse row copy of one of the adjacency lists; rebuilt lazily after nodes or edges are added.
+	struct CSR {
+		std::vector<int> offsets;
+		std::vector<Edge> edges;
+		void build(const std::vector<std::vector<Edge> > & lists) {
+			offsets.resize(lists.size() + 1);
+			edges.clear();
+			for (int n = 0; n < lists.size(); n++) {
+				offsets[n] = edges.size();
+				edges.insert(edges.end(), lists[n].begin(), lists[n].end());
+			}
+			offsets[lists.size()] = edges.size();
+		}
+		EdgeRange range(int node) const {
+			return {edges.data() + offsets[node], edges.data() + offsets[node+1]};
+		}
+	};
+	CSR csr_out;
+	CSR csr_in;
+	CSR csr_undirected;
+	bool csr_valid = false;
 public:
 	struct FullEdge {
 		int from;
@@ -128,9 +177,35 @@ public:
 		
 	}
 	
+	//Add n nodes at once; unlike calling addNode() n times, this only invalidates the graph's history once.
 	void addNodes(int n) {
-		for (int i = 0; i < n; i++)
-			addNode();
+		if (n <= 0)
+			return;
+		adjacency_list.resize(num_nodes + n);
+		adjacency_undirected_list.resize(num_nodes + n);
+		inverted_adjacency_list.resize(num_nodes + n);
+		modifications++;
+		additions = modifications;
+		deletions = modifications;
+		edge_increases = modifications;
+		edge_decreases = modifications;
+		csr_valid = false;
+		markChanged();
+		clearHistory(true);
+
+		if (outfile) {
+			for (int i = 0; i < n; i++)
+				fprintf(outfile, "node %d\n", num_nodes + i);
+			fflush(outfile);
+		}
+		num_nodes += n;
+	}
+	//Reserve space for n more edges.
+	void reserveEdges(int n) {
+		edge_status.reserve(next_id + n);
+		edge_status_const.reserve(next_id + n);
+		all_edges.reserve(next_id + n);
+		weights.reserve(next_id + n);
 	}
 	//Returns true iff the edge exists and is a self loop
 	inline bool selfLoop(int edgeID)  {
@@ -173,6 +248,7 @@ public:
 		deletions = modifications;
 		edge_increases = modifications;
 		edge_decreases = modifications;
+		csr_valid = false;
 		markChanged();
 		clearHistory(true);
 
@@ -238,6 +314,7 @@ public:
 		modifications++;
 		additions = modifications;
 		edge_increases = modifications;
+		csr_valid = false;
 		markChanged();
 		
 
@@ -322,6 +399,46 @@ public:
 			return inverted_adjacency_list[node][i];
 		}
 	}
+	/**
+	 * The outgoing edges of a node (or all incident edges, if undirected is true), in the same order as incident().
+	 */
+	inline EdgeRange outEdges(int node, bool undirected = false) {
+		assert(node >= 0);
+		assert(node < nodes());
+		if (!use_csr) {
+			const std::vector<Edge> & list = undirected ? adjacency_undirected_list[node] : adjacency_list[node];
+			return {list.data(), list.data() + list.size()};
+		}
+		updateSnapshot();
+		return undirected ? csr_undirected.range(node) : csr_out.range(node);
+	}
+	/**
+	 * The incoming edges of a node (or all incident edges, if undirected is true), in the same order as incoming().
+	 */
+	inline EdgeRange inEdges(int node, bool undirected = false) {
+		assert(node >= 0);
+		assert(node < nodes());
+		if (!use_csr) {
+			const std::vector<Edge> & list = undirected ? adjacency_undirected_list[node] : inverted_adjacency_list[node];
+			return {list.data(), list.data() + list.size()};
+		}
+		updateSnapshot();
+		return undirected ? csr_undirected.range(node) : csr_in.range(node);
+	}
+	/**
+	 * Rebuild the compressed sparse row snapshot if nodes or edges were added since it was last built.
+	 * This happens automatically in outEdges()/inEdges(), but must be called explicitly before
+	 * the graph is traversed by several threads at once.
+	 */
+	void updateSnapshot() {
+		if (!csr_valid && use_csr) {
+			csr_out.build(adjacency_list);
+			csr_in.build(inverted_adjacency_list);
+			csr_undirected.build(adjacency_undirected_list);
+			csr_valid = true;
+		}
+	}
+
 	std::vector<FullEdge> & getEdges(){
 		return all_edges;
 	}
@@ -653,6 +770,7 @@ public:
 
 	void clear(){
 		edge_status.clear();
+		csr_valid = false;
 		num_nodes=0;
 		num_edges=0;
 		next_id=0;
@@ -678,6 +796,7 @@ public:
 		to.adjacency_undirected_list=adjacency_undirected_list;
 		to.all_edges =all_edges;
 		to.inverted_adjacency_list=inverted_adjacency_list;
+		to.use_csr = use_csr;
 
 
 	}
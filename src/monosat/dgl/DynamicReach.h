@@ -0,0 +1,335 @@
+/****************************************************************************************[DynamicReach.h]
+ The MIT License (MIT)
+
+ Copyright (c) 2014, Sam Bayless
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ associated documentation files (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or
+ substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **************************************************************************************************/
+
+#ifndef DYNAMICREACH_H_
+#define DYNAMICREACH_H_
+
+#include <vector>
+#include <cassert>
+#include "DynamicGraph.h"
+#include "Reach.h"
+
+namespace dgl {
+
+/**
+ * Fully dynamic single-source reachability.
+ *
+ * Maintains a spanning tree of the nodes reachable from the source (in the style of an Even-Shiloach tree,
+ * but without the distance labels, which reachability does not need), and repairs it by consuming the graph's edge history:
+ *
+ * - Enabling an edge from a reached node to an unreached node searches forward from the newly reached node only.
+ * - Disabling an edge that is not in the tree costs O(1).
+ * - Disabling a tree edge only re-examines the subtree that hung below it: the subtree is detached, nodes in it
+ *   that still have an enabled incoming edge from a reached node are re-attached, and the search resumes forward from them.
+ *
+ * So the cost of an update is proportional to the affected region of the graph, rather than to the number of edges.
+ *
+ * The algorithm keeps its own copy of the enabled status of each edge, so that if the graph's history is cleared
+ * it can resynchronize by comparing edge assignments, rather than recomputing reachability from scratch.
+ * Only the nodes whose reachability changed since the last update are reported to the status object.
+ */
+template<typename Weight, class Status = Reach::NullStatus>
+class DynamicReachability: public Reach, public DynamicGraphAlgorithm {
+public:
+	DynamicGraph<Weight> & g;
+	Status & status;
+	const int reportPolarity;
+	int last_modification = -1;
+	int last_history_clear = 0;
+	int history_qhead = 0;
+	int source;
+	int alg_id;
+
+	std::vector<char> reached;
+	std::vector<int> parent_edge;
+	//the enabled status of each edge, as of the last update
+	std::vector<char> edge_enabled;
+	//the reachability of each node, as of the last time it was reported (or -1, if it has never been reported)
+	std::vector<signed char> reported;
+	std::vector<char> node_changed;
+	std::vector<int> changed;
+	std::vector<int> q;
+	std::vector<int> detached;
+
+public:
+	long stats_full_updates = 0;
+	long stats_fast_updates = 0;
+	long stats_skipped_updates = 0;
+	long stats_history_resyncs = 0;
+	long stats_tree_deletions = 0;
+	long stats_detached_nodes = 0;
+	long num_updates = 0;
+
+	DynamicReachability(int s, DynamicGraph<Weight> & graph, Status & _status = Reach::nullStatus,
+			int _reportPolarity = 0) :
+			g(graph), status(_status), reportPolarity(_reportPolarity), source(s) {
+		alg_id = g.addDynamicAlgorithm(this);
+	}
+
+	void setSource(int s) {
+		source = s;
+		last_modification = -1;
+	}
+	int getSource() {
+		return source;
+	}
+	int numUpdates() const {
+		return num_updates;
+	}
+
+	void update() {
+		if (last_modification > 0 && g.modifications == last_modification) {
+			stats_skipped_updates++;
+			return;
+		}
+		if (last_modification < 0) {
+			recompute();
+		} else {
+			stats_fast_updates++;
+			grow();
+			if (last_history_clear != g.historyclears) {
+				//the history that was not yet consumed is gone; compare against the saved edge assignment instead.
+				stats_history_resyncs++;
+				for (int edgeID = 0; edgeID < g.edges(); edgeID++) {
+					applyChange(edgeID);
+				}
+			} else {
+				for (int i = history_qhead; i < g.historySize(); i++) {
+					applyChange(g.getChange(i).id);
+				}
+			}
+		}
+		report();
+		assert(dbg_uptodate());
+		num_updates++;
+		last_modification = g.modifications;
+		history_qhead = g.historySize();
+		last_history_clear = g.historyclears;
+		g.updateAlgorithmHistory(this, alg_id, history_qhead);
+	}
+
+	void updateHistory() {
+		update();
+	}
+
+	bool connected_unsafe(int t) {
+		return t < reached.size() && reached[t];
+	}
+	bool connected_unchecked(int t) {
+		assert(last_modification == g.modifications);
+		return connected_unsafe(t);
+	}
+	bool connected(int t) {
+		if (last_modification != g.modifications)
+			update();
+		return connected_unsafe(t);
+	}
+	int incomingEdge(int t) {
+		assert(t >= 0 && t < parent_edge.size());
+		return parent_edge[t];
+	}
+	int previous(int t) {
+		if (parent_edge[t] < 0)
+			return -1;
+		return g.getEdge(parent_edge[t]).from;
+	}
+
+private:
+
+	void recompute() {
+		stats_full_updates++;
+		reached.clear();
+		parent_edge.clear();
+		edge_enabled.clear();
+		reported.clear();
+		node_changed.clear();
+		changed.clear();
+		grow();
+		for (int edgeID = 0; edgeID < g.edges(); edgeID++) {
+			edge_enabled[edgeID] = g.edgeEnabled(edgeID);
+		}
+		for (int u = 0; u < g.nodes(); u++) {
+			//On the first round, report the status of all nodes.
+			markChanged(u);
+		}
+		if (source < g.nodes()) {
+			reached[source] = true;
+			search(source);
+		}
+	}
+
+	//Extend the internal state to cover any nodes or edges that were added to the graph.
+	void grow() {
+		int n = reached.size();
+		if (n < g.nodes()) {
+			reached.resize(g.nodes(), false);
+			parent_edge.resize(g.nodes(), -1);
+			reported.resize(g.nodes(), -1);
+			node_changed.resize(g.nodes(), false);
+			for (int u = n; u < g.nodes(); u++) {
+				markChanged(u);
+			}
+			if (source >= n && source < g.nodes()) {
+				reached[source] = true;
+				search(source);
+			}
+		}
+		if (edge_enabled.size() < g.edges())
+			edge_enabled.resize(g.edges(), false);
+	}
+
+	inline void markChanged(int u) {
+		if (!node_changed[u]) {
+			node_changed[u] = true;
+			changed.push_back(u);
+		}
+	}
+
+	//Bring the given edge up to date with its current assignment in the graph.
+	void applyChange(int edgeID) {
+		bool enabled = g.edgeEnabled(edgeID);
+		if (edge_enabled[edgeID] == enabled)
+			return;
+		edge_enabled[edgeID] = enabled;
+		int from = g.getEdge(edgeID).from;
+		int to = g.getEdge(edgeID).to;
+		if (enabled) {
+			if (reached[from] && !reached[to]) {
+				reached[to] = true;
+				parent_edge[to] = edgeID;
+				markChanged(to);
+				search(to);
+			}
+		} else if (reached[to] && parent_edge[to] == edgeID) {
+			assert(to != source);
+			stats_tree_deletions++;
+			repair(to);
+		}
+	}
+
+	//Forward search from a newly reached node, over enabled edges, to nodes that are not yet reached.
+	void search(int start) {
+		q.clear();
+		q.push_back(start);
+		for (int i = 0; i < q.size(); i++) {
+			int u = q[i];
+			assert(reached[u]);
+			for (auto & e : g.outEdges(u)) {
+				int edgeID = e.id;
+				if (!g.edgeEnabled(edgeID))
+					continue;
+				int v = e.node;
+				if (!reached[v]) {
+					reached[v] = true;
+					parent_edge[v] = edgeID;
+					markChanged(v);
+					q.push_back(v);
+				}
+			}
+		}
+	}
+
+	//The tree edge into 'root' was disabled; detach the subtree below it and re-attach whatever is still reachable.
+	void repair(int root) {
+		detached.clear();
+		detached.push_back(root);
+		reached[root] = false;
+		parent_edge[root] = -1;
+		for (int i = 0; i < detached.size(); i++) {
+			int u = detached[i];
+			//tree edges may be disabled edges whose change has not been consumed yet, so check every outgoing edge.
+			for (auto & e : g.outEdges(u)) {
+				int edgeID = e.id;
+				int v = e.node;
+				if (reached[v] && parent_edge[v] == edgeID) {
+					reached[v] = false;
+					parent_edge[v] = -1;
+					detached.push_back(v);
+				}
+			}
+		}
+		stats_detached_nodes += detached.size();
+		//any node that is still reachable must have a reachable path entering the subtree from outside it.
+		for (int i = 0; i < detached.size(); i++) {
+			int u = detached[i];
+			markChanged(u);
+			if (reached[u])
+				continue;			//re-attached by an earlier search
+			for (auto & e : g.inEdges(u)) {
+				int edgeID = e.id;
+				if (g.edgeEnabled(edgeID) && reached[e.node]) {
+					reached[u] = true;
+					parent_edge[u] = edgeID;
+					search(u);
+					break;
+				}
+			}
+		}
+	}
+
+	void report() {
+		for (int u : changed) {
+			node_changed[u] = false;
+			bool r = reached[u];
+			if (reported[u] == (signed char) r)
+				continue;
+			reported[u] = r;
+			if (!r && reportPolarity <= 0) {
+				status.setReachable(u, false);
+			} else if (r && reportPolarity >= 0) {
+				status.setReachable(u, true);
+			}
+		}
+		changed.clear();
+	}
+
+	bool dbg_uptodate() {
+#ifdef DEBUG_DYNAMIC_REACH
+		std::vector<char> seen(g.nodes(), false);
+		std::vector<int> stack;
+		seen[source] = true;
+		stack.push_back(source);
+		while (stack.size()) {
+			int u = stack.back();
+			stack.pop_back();
+			for (auto & e : g.outEdges(u)) {
+				int v = e.node;
+				if (g.edgeEnabled(e.id) && !seen[v]) {
+					seen[v] = true;
+					stack.push_back(v);
+				}
+			}
+		}
+		for (int u = 0; u < g.nodes(); u++) {
+			assert(seen[u] == reached[u]);
+			if (reached[u] && u != source) {
+				assert(parent_edge[u] >= 0 && g.edgeEnabled(parent_edge[u]));
+				assert(reached[previous(u)]);
+			}
+		}
+#endif
+		return true;
+	}
+};
+
+}
+;
+#endif /* DYNAMICREACH_H_ */
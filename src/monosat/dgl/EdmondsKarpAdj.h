@@ -81,11 +81,11 @@ public:
 		for (int j = 0; j < Q.size(); j++) {
 			int u = Q[j];
 			
-			for (int i = 0; i < g.nIncident(u); i++) {
-				if (!g.edgeEnabled(g.incident(u, i).id))
+			for (auto & e : g.outEdges(u)) {
+				if (!g.edgeEnabled(e.id))
 					continue;
-				int id = g.incident(u, i).id;
-				int v = g.incident(u, i).node;
+				int id = e.id;
+				int v = e.node;
 				///(If there is available capacity, and v is not seen before in search)
 				
 				Weight &f = F[id];
@@ -103,12 +103,12 @@ public:
 				}
 			}
 			
-			for (int i = 0; i < g.nIncoming(u); i++) {
-				int id = g.incoming(u, i).id;
+			for (auto & e : g.inEdges(u)) {
+				int id = e.id;
 				if (!g.edgeEnabled(id))
 					continue;
 				
-				int v = g.incoming(u, i).node;
+				int v = e.node;
 				
 				Weight f = 0;
 				Weight& c = F[id];
@@ -331,11 +331,11 @@ public:
 		for (int j = 0; j < Q.size(); j++) {
 			int u = Q[j];
 			
-			for (int i = 0; i < g.nIncident(u); i++) {
-				if (!g.edgeEnabled(g.incident(u, i).id))
+			for (auto & e : g.outEdges(u)) {
+				if (!g.edgeEnabled(e.id))
 					continue;
-				int v = g.incident(u, i).node;
-				int id = g.incident(u, i).id;
+				int v = e.node;
+				int id = e.id;
 				if ((g.getWeight(id) - F[id] == 0) && (F[id]>0)) {
 					cut.push_back(MaxFlowEdge { u, v, id });    	//potential element of the cut
 				} else if (!seen[v]) {
@@ -343,11 +343,11 @@ public:
 					seen[v] = true;
 				}
 			}
-			for (int i = 0; i < g.nIncoming(u); i++) {
-				if (!g.edgeEnabled(g.incoming(u, i).id))
+			for (auto & e : g.inEdges(u)) {
+				if (!g.edgeEnabled(e.id))
 					continue;
-				int v = g.incoming(u, i).node;
-				int id = g.incoming(u, i).id;
+				int v = e.node;
+				int id = e.id;
 				if (F[id] == 0) {
 					
 				} else if (!seen[v]) {
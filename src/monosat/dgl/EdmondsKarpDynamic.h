@@ -172,6 +172,8 @@ public:
 		
 	}
 	long num_updates = 0;
+	long stats_full_calcs = 0;
+	long stats_warm_restarts = 0;
 	int numUpdates() const {
 		return num_updates;
 	}
@@ -226,7 +228,8 @@ public:
 			assert(curflow==expected_flow);
 #endif
 			return curflow;
-		} else if (last_modification <= 0 || g.historyclears != last_history_clear || g.changed()) {
+		} else if (last_modification <= 0 || F.size() != g.edges() || prev.size() != g.nodes() || !warmRestart()) {
+			stats_full_calcs++;
 			F.clear();
 			F.resize(g.edges());
 			changed.resize(g.nEdgeIDs());
@@ -261,6 +264,14 @@ public:
 		bool added_Edges = false;
 		bool needsReflow = false;
 		
+		if (warm_restarted) {
+			//the changes since the last update were already applied (without the history) by warmRestart()
+			warm_restarted = false;
+			added_Edges = true;
+			needsReflow = needs_reflow_after_restart;
+			history_qhead = g.historySize();
+		}
+
 		for (int i = history_qhead; i < g.historySize(); i++) {
 			int edgeid = g.getChange(i).id;
 			if (g.getChange(i).addition && g.edgeEnabled(edgeid)) {
@@ -269,36 +280,8 @@ public:
 			} else if (!g.getChange(i).addition && !g.edgeEnabled(edgeid)) {
 				//assert(edge_enabled[edgeid]);
 				edge_enabled[edgeid] = false;
-				Weight fv = F[edgeid]; //g.all_edges[edgeid].from;
-				if (fv == 0) {
-					//do nothing.
-				} else {
-					//ok, check if the maxflow from u to v has not lowered now that we've removed this edge.
-					//if it hasn't, then we are still safe
-					int u = g.getEdge(edgeid).from;
-					int v = g.getEdge(edgeid).to;
-					
-					if (fv < 0) {
-						std::swap(u, v);
-						fv = -fv;
-					}
-					assert(fv > 0);
-					Weight flow = maxFlow_residual(u, v, fv);    					//fix this!
-					assert(flow <= fv);
-					if (flow == fv) {
-						//then we are ok.
-					} else {
-						//the total flow in the network has to be decreased by delta.
-						Weight delta = fv - flow;
-						assert(delta > 0);
-						needsReflow = true;
-						//temporarily connect s and t by an arc of infinite capacity and run maxflow algorithm again from vin to vout
-						flow = maxFlow_p(u, v, s, t, delta);
-						//f-=flow;//this doesn't work
-					}
-					F[edgeid] = 0;
-					markChanged(edgeid);
-				}
+				if (removeEdgeFlow(edgeid))
+					needsReflow = true;
 			}
 		}
 		
@@ -411,7 +394,79 @@ public:
 	}
 	
 private:
-	
+	bool warm_restarted = false;
+	bool needs_reflow_after_restart = false;
+
+	//Remove the flow on a newly disabled edge, rerouting it around that edge where possible.
+	//Returns true if the total s-t flow had to be reduced (in which case it needs to be recounted).
+	bool removeEdgeFlow(int edgeid) {
+		assert(!edge_enabled[edgeid]);
+		Weight fv = F[edgeid]; //g.all_edges[edgeid].from;
+		if (fv == 0) {
+			//do nothing.
+			return false;
+		}
+		bool reduced = false;
+		//ok, check if the maxflow from u to v has not lowered now that we've removed this edge.
+		//if it hasn't, then we are still safe
+		int u = g.getEdge(edgeid).from;
+		int v = g.getEdge(edgeid).to;
+
+		if (fv < 0) {
+			std::swap(u, v);
+			fv = -fv;
+		}
+		assert(fv > 0);
+		Weight flow = maxFlow_residual(u, v, fv);    					//fix this!
+		assert(flow <= fv);
+		if (flow == fv) {
+			//then we are ok.
+		} else {
+			//the total flow in the network has to be decreased by delta.
+			Weight delta = fv - flow;
+			assert(delta > 0);
+			reduced = true;
+			//temporarily connect s and t by an arc of infinite capacity and run maxflow algorithm again from vin to vout
+			flow = maxFlow_p(u, v, source, sink, delta);
+			//f-=flow;//this doesn't work
+		}
+		F[edgeid] = 0;
+		markChanged(edgeid);
+		return reduced;
+	}
+
+	/**
+	 * After the graph's history has been cleared (or the graph was marked as changed), the individual edge changes
+	 * since the last update are no longer available. Rather than recomputing the flow from scratch, compare the
+	 * graph against the locally recorded edge states, and repair the previous flow around just the edges that were
+	 * disabled since then; update() then augments that flow along any new paths.
+	 * Returns false if the previous flow cannot be reused (because an edge's capacity dropped below its flow).
+	 */
+	bool warmRestart() {
+		if (g.historyclears == last_history_clear && !g.changed()) {
+			return true;
+		}
+		for (int i = 0; i < g.edges(); i++) {
+			if (edge_enabled[i] && g.isEdge(i) && g.edgeEnabled(i) && F[i] > g.getWeight(i)) {
+				return false;
+			}
+		}
+		stats_warm_restarts++;
+		needs_reflow_after_restart = false;
+		for (int i = 0; i < g.edges(); i++) {
+			bool enabled = g.isEdge(i) && g.edgeEnabled(i);
+			if (enabled && !edge_enabled[i]) {
+				edge_enabled[i] = true;
+			} else if (!enabled && edge_enabled[i]) {
+				edge_enabled[i] = false;
+				if (removeEdgeFlow(i))
+					needs_reflow_after_restart = true;
+			}
+		}
+		warm_restarted = true;
+		return true;
+	}
+
 	void markChanged(int edgeID) {
 		if (!changed[edgeID]) {
 			changed[edgeID] = true;
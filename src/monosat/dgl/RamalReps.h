@@ -306,8 +306,7 @@ public:
 			}
 			delta[u] = 0;
 			//for(auto & e:g.inverted_adjacency[u]){
-			for (int i = 0; i < g.nIncoming(u); i++) {
-				auto & e = g.incoming(u, i);
+			for (auto & e : g.inEdges(u)) {
 				int adjID = e.id;
 				if (g.edgeEnabled(adjID)) {
 					
@@ -334,8 +333,7 @@ public:
 				}
 			}
 			
-			for (int i = 0; i < g.nIncident(u); i++) {
-				auto & e = g.incident(u, i);
+			for (auto & e : g.outEdges(u)) {
 				int adjID = e.id;
 				if (g.edgeEnabled(adjID)) {
 					assert(g.getEdge(adjID).from == u);
@@ -361,8 +359,7 @@ public:
 			int del = delta[u];
 			Weight d = dist[u];
 			int num_in = 0;
-			for (int i = 0; i < g.nIncoming(u); i++) {
-				auto & e = g.incoming(u, i);
+			for (auto & e : g.inEdges(u)) {
 				int adjID = e.id;
 				int from = g.getEdge(adjID).from;
 				
@@ -399,8 +396,7 @@ public:
 		for (int i = 0; i < changeset.size(); i++) {
 			int u = changeset[i];
 			dist[u] = INF;
-			for (int i = 0; i < g.nIncident(u); i++) {
-				auto & e = g.incident(u, i);
+			for (auto & e : g.outEdges(u)) {
 				int adjID = e.id;
 				if (g.edgeEnabled(adjID)) {
 					if (edgeInShortestPathGraph[adjID]) {
@@ -420,8 +416,7 @@ public:
 		for (int i = 0; i < changeset.size(); i++) {
 			int u = changeset[i];
 			assert(dist[u] == INF);
-			for (int i = 0; i < g.nIncoming(u); i++) {
-				auto & e = g.incoming(u, i);
+			for (auto & e : g.inEdges(u)) {
 				int adjID = e.id;
 				
 				if (g.edgeEnabled(adjID)) {
@@ -473,8 +468,7 @@ public:
 					}
 				}
 			}
-			for (int i = 0; i < g.nIncident(u); i++) {
-				auto & e = g.incident(u, i);
+			for (auto & e : g.outEdges(u)) {
 				int adjID = e.id;
 				if (g.edgeEnabled(adjID)) {
 					assert(g.getEdge(adjID).from == u);
@@ -500,8 +494,7 @@ public:
 				}
 			}
 			
-			for (int i = 0; i < g.nIncoming(u); i++) {
-				auto & e = g.incoming(u, i);
+			for (auto & e : g.inEdges(u)) {
 				int adjID = e.id;
 				if (g.edgeEnabled(adjID)) {
 					
@@ -1066,8 +1059,7 @@ public:
 			}
 			delta[u] = 0;
 			//for(auto & e:g.inverted_adjacency[u]){
-			for (int j = 0; j < g.nIncoming(u); j++) {
-				auto & e = g.incoming(u, j);
+			for (auto & e : g.inEdges(u)) {
 				int adjID = e.id;
 				if (g.edgeEnabled(adjID)) {
 					
@@ -1098,8 +1090,7 @@ public:
 				}
 			}
 			
-			for (int j = 0; j < g.nIncident(u); j++) {
-				auto & e = g.incident(u, j);
+			for (auto & e : g.outEdges(u)) {
 				int adjID = e.id;
 				if (g.edgeEnabled(adjID)) {
 					assert(g.getEdge(adjID).from == u);
@@ -1182,8 +1173,7 @@ public:
 			int del = delta[u];
 			int d = dist[u];
 			int num_in = 0;
-			for (int i = 0; i < g.nIncoming(u); i++) {
-				auto & e = g.incoming(u, i);
+			for (auto & e : g.inEdges(u)) {
 				int adjID = e.id;
 				int from = g.getEdge(adjID).from;
 				
@@ -1231,8 +1221,7 @@ public:
 			int u = changeset[i];
 			
 			dist[u] = INF;
-			for (int i = 0; i < g.nIncident(u); i++) {
-				auto & e = g.incident(u, i);
+			for (auto & e : g.outEdges(u)) {
 				int adjID = e.id;
 				if (g.edgeEnabled(adjID)) {
 					if (edgeInShortestPathGraph[adjID]) {
@@ -1255,8 +1244,7 @@ public:
 			
 			assert(dist[u] == INF);
 			//for(auto & e:g.inverted_adjacency[u]){
-			for (int i = 0; i < g.nIncoming(u); i++) {
-				auto & e = g.incoming(u, i);
+			for (auto & e : g.inEdges(u)) {
 				int adjID = e.id;
 				
 				if (g.edgeEnabled(adjID)) {
@@ -1329,8 +1317,7 @@ public:
 			dbg_Q_order(q);
 			dbg_Q_order(q2);
 			
-			for (int i = 0; i < g.nIncident(u); i++) {
-				auto & e = g.incident(u, i);
+			for (auto & e : g.outEdges(u)) {
 				int adjID = e.id;
 				if (g.edgeEnabled(adjID)) {
 					assert(g.getEdge(adjID).from == u);
@@ -1366,8 +1353,7 @@ public:
 				}
 			}
 			
-			for (int i = 0; i < g.nIncoming(u); i++) {
-				auto & e = g.incoming(u, i);
+			for (auto & e : g.inEdges(u)) {
 				int adjID = e.id;
 				if (g.edgeEnabled(adjID)) {
 					
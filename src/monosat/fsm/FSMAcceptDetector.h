@@ -123,6 +123,11 @@ public:
 		if(opt_fsm_symmetry_breaking){
 			printf("Symmetry breaking conflicts: %ld\n", stats_symmetry_conflicts);
 		}
+		if (opt_verb > 0) {
+			printf("\tStrings simulated (under,over): %ld, %ld (%ld, %ld cached)\n",
+					underapprox_detector->stats_strings_simulated, overapprox_detector->stats_strings_simulated,
+					underapprox_detector->stats_strings_cached, overapprox_detector->stats_strings_cached);
+		}
 	}
 	
 	void unassign(Lit l) {
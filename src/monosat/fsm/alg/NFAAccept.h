@@ -12,62 +12,79 @@
 #include <monosat/fsm/alg/NFATypes.h>
 #include <monosat/fsm/DynamicFSM.h>
 #include <monosat/mtl/Vec.h>
-//#include "monosat/mtl/Bitset.h"
+#include "monosat/mtl/Bitset.h"
 #include <cassert>
 #include <vector>
 
 using namespace Monosat;
 
 
+/**
+ * Tracks, for each string, which states of the NFA accept it.
+ *
+ * Sets of states are simulated word-parallel: for each label (with 0 for emoves), the engine keeps a bitset of the
+ * successors of each state, so a step of the simulation ORs together one row per active state, and the emove closure
+ * is a fixed point over those rows.
+ *
+ * Results are cached per string. Along with each string's accepting states, the engine records, for each label in
+ * the string, the set of states that were active just before that label was consumed (and for emoves, every state
+ * that was active at any point). A transition from state s on label l can only change the result for a string if s
+ * was active before l in that string, so after each change, only the strings that touch a changed transition are re-simulated.
+ */
 template<class Status=FSMNullStatus>
 class NFAAccept{
 	DynamicFSM & g;
 	Status & status;
 	int last_modification=-1;
-
-	int last_addition=-1;
-	int last_deletion=-1;
 	int history_qhead=0;
 	int last_history_clear=0;
 
+public:
 	long stats_full_updates=0;
 	long stats_fast_updates=0;
-	long stats_fast_failed_updates=0;
-	long stats_skip_deletes=0;
 	long stats_skipped_updates=0;
-	long stats_skipped_string_updates=0;
-	long stats_num_skipable_deletions=0;
-	double mod_percentage=0;
-
-	double stats_full_update_time=0;
-	double stats_fast_update_time=0;
-
-
-
-	vec<int> next;
-	vec<int> accepts;
-
-	vec<bool> next_seen;
-	vec<bool> cur_seen;
+	long stats_strings_simulated=0;
+	long stats_strings_cached=0;
+private:
 
 	int source;
 	vec<vec<int>> & strings;
-	vec<vec<bool>>  usedTransitions;
-	bool checkUsed=true;
-	bool hasUsed=false;
-
-	vec<vec<int>> states_to_track_positive;//for each string, which states that might be accepted that we should track (for acceptance)
-	vec<vec<int>> states_to_track_negative;//for each string, which states that might be accepted that we should track (for rejection)
-
-	vec<vec<bool>> states_were_accepting;
-	//vec<vec<bool>> states_were_rejecting;
+	//if false, every string is re-simulated after each change
+	bool trackUsed=true;
+
+	//successors[l][s] is the set of states reachable from s by one enabled transition on label l (with output 0)
+	vec<vec<Bitset>> successors;
+	int n_states=0;
+	int n_labels=0;
+	int n_words=0;
+	bool had_emoves=false;
+
+	struct StringCache{
+		bool valid=false;
+		Bitset accepting;
+		//touched[i] is the set of states that were active before consuming touched_labels[i]
+		vec<int> touched_labels;
+		vec<Bitset> touched;
+	};
+	vec<StringCache> cache;
+
+	//the result of the last simulation
+	Bitset cur;
+	Bitset next;
+	Bitset frontier;
+	Bitset tmp;
+	vec<int> label_index;
+	vec<int> changed_from;
+	vec<int> changed_label;
+
+	vec<vec<bool>> states_to_track_positive;//for each string, which states that might be accepted that we should track (for acceptance)
+	vec<vec<bool>> states_to_track_negative;//for each string, which states that might be accepted that we should track (for rejection)
 	vec<int> n_trackingString;
-	bool hasAcceptanceStates=false;
 
 	int n_track_positive=0;
 	int n_track_negative=0;
 public:
-	NFAAccept(DynamicFSM & f,int source, vec<vec<int>> & strings,Status & status=fsmNullStatus, bool trackUsedTransitions=false):g(f),status(status),source(source),strings(strings),checkUsed(trackUsedTransitions){
+	NFAAccept(DynamicFSM & f,int source, vec<vec<int>> & strings,Status & status=fsmNullStatus, bool trackUsedTransitions=false):g(f),status(status),source(source),strings(strings),trackUsed(trackUsedTransitions){
 
 		buildStringTrackers();
 	}
@@ -77,15 +94,10 @@ private:
 		states_to_track_positive.growTo(strings.size());
 		states_to_track_negative.growTo(strings.size());
 		n_trackingString.growTo(strings.size(),g.states()*2);
-		states_were_accepting.growTo(strings.size());
-		//states_were_rejecting.growTo(strings.size());
 
 		for(int i = 0;i<strings.size();i++){
 			states_to_track_positive[i].growTo(g.states(),true);
 			states_to_track_negative[i].growTo(g.states(),true);
-
-			states_were_accepting[i].growTo(g.states());
-			//states_were_rejecting[i].growTo(f.states());
 		}
 
 		n_track_positive = strings.size();
@@ -125,99 +137,180 @@ public:
 
 private:
 
-	void markUsed(int edgeID, int labelIn, int labelOut){
-		assert(labelOut==0);
-		if(checkUsed){
-			hasUsed=true;
-			usedTransitions[edgeID][labelIn]=true;
-		}
+	void newSet(Bitset & set){
+		set.clear();
+		set.growTo(n_states);
 	}
 
-	void find_accepts(int str){
+	//Recompute the row of successors of state 'from' on 'label' (only the bit for 'to' can have changed)
+	void updateSuccessor(int from, int to, int label){
+		bool enabled=false;
+		for(int j = 0;j<g.nIncident(from);j++){
+			if(g.incident(from,j).node==to && g.transitionEnabled(g.incident(from,j).id,label,0)){
+				enabled=true;
+				break;
+			}
+		}
+		if(enabled)
+			successors[label][from].set(to);
+		else
+			successors[label][from].clear(to);
+	}
 
-		for(int s:accepts){
-			assert(cur_seen);
-			cur_seen[s]=false;
+	void buildSuccessors(){
+		n_states=g.states();
+		n_labels=g.inAlphabet();
+		had_emoves=g.emovesEnabled();
+		successors.growTo(n_labels);
+		for(int l = 0;l<n_labels;l++){
+			successors[l].growTo(n_states);
+			for(int s = 0;s<n_states;s++){
+				newSet(successors[l][s]);
+			}
+		}
+		for(int s = 0;s<n_states;s++){
+			for(int j = 0;j<g.nIncident(s);j++){
+				int edgeID= g.incident(s,j).id;
+				int to = g.incident(s,j).node;
+				for(int l = 0;l<n_labels;l++){
+					if(g.transitionEnabled(edgeID,l,0))
+						successors[l][s].set(to);
+				}
+			}
 		}
-		accepts.clear();
-		assert(next.size()==0);
-		cur_seen[source]=true;
-		accepts.push(source);
+		newSet(cur);
+		n_words=cur.nWords();
+		newSet(next);
+		newSet(frontier);
+		newSet(tmp);
+	}
 
-		vec<int> & string = strings[str];
+	//out |= the successors of all states in 'from', on 'label'
+	inline void step(const Bitset & from, int label, Bitset & out){
+		vec<Bitset> & rows = successors[label];
+		for(int w = 0;w<n_words;w++){
+			uint64_t bits = from.getWord(w);
+			while(bits){
+				int s = w*64 + __builtin_ctzll(bits);
+				bits &= bits-1;
+				out.Or(rows[s]);
+			}
+		}
+	}
 
-		//initial emove pass:
+	//Extend 'set' with every state reachable from it by emoves; if reached is non-null, the states of 'set' are also added to it.
+	void closure(Bitset & set, Bitset * reached){
 		if(g.emovesEnabled()){
-			for(int i = 0;i<accepts.size();i++){
-				int s = accepts[i];
-				for(int j = 0;j<g.nIncident(s);j++){
-					//now check if the label is active
-					int edgeID= g.incident(s,j).id;
-					int to = g.incident(s,j).node;
-					if(!cur_seen[to] && g.transitionEnabled(edgeID,0,0)){
-						cur_seen[to]=true;
-						accepts.push(to);
-						markUsed(edgeID,0,0);
-					}
-
+			set.copyTo(frontier);
+			while(true){
+				newSet(tmp);
+				step(frontier,0,tmp);
+				bool any=false;
+				for(int w = 0;w<n_words;w++){
+					uint64_t added = tmp.getWord(w) & ~set.getWord(w);
+					frontier.setWord(w,added);
+					set.setWord(w,set.getWord(w)|added);
+					any|=added!=0;
 				}
+				if(!any)
+					break;
 			}
 		}
+		if(reached)
+			reached->Or(set);
+	}
 
-		for(int l:string)
-		{
-			assert(l>0);
-			for(int i = 0;i<accepts.size();i++){
-				int s = accepts[i];
-				for(int j = 0;j<g.nIncident(s);j++){
-					//now check if the label is active
-					int edgeID= g.incident(s,j).id;
-					int to = g.incident(s,j).node;
-					if(!cur_seen[to] && g.transitionEnabled(edgeID,0,0)){
-						cur_seen[to]=true;
-						accepts.push(to);
-						markUsed(edgeID,0,0);
-						//status.reaches(str,to,edgeID,0);
-					}
-
-					if (!next_seen[to] && g.transitionEnabled(edgeID,l,0)){
-						//status.reaches(str,to,edgeID,l);
-						next_seen[to]=true;
-						next.push(to);
-						markUsed(edgeID,l,0);
-					}
+	//Simulate the string, leaving its accepting states in cur; if c is non-null, also record which states each label was applied to.
+	void simulate(int str, StringCache * c){
+		stats_strings_simulated++;
+		vec<int> & string = strings[str];
+		Bitset * emoves=nullptr;
+		if(c){
+			c->touched_labels.clear();
+			c->touched.clear();
+			label_index.growTo(n_labels,-1);
+			if(g.emovesEnabled()){
+				c->touched_labels.push(0);
+				c->touched.push();
+				newSet(c->touched.last());
+				label_index[0]=0;
+			}
+			for(int l:string){
+				if(label_index[l]<0){
+					label_index[l]=c->touched.size();
+					c->touched_labels.push(l);
+					c->touched.push();
+					newSet(c->touched.last());
 				}
 			}
+			if(g.emovesEnabled())
+				emoves=&c->touched[0];
+		}
+		newSet(cur);
+		cur.set(source);
+		closure(cur,emoves);
+		for(int l:string){
+			assert(l>0);
+			if(c)
+				c->touched[label_index[l]].Or(cur);
+			newSet(next);
+			step(cur,l,next);
+			closure(next,emoves);
+			cur.swap(next);
+		}
+		if(c){
+			for(int l:c->touched_labels)
+				label_index[l]=-1;
+			cur.copyTo(c->accepting);
+			c->valid=true;
+		}
+	}
 
-			next.swap(accepts);
-			next_seen.swap(cur_seen);
-
-			for(int s:next){
-				assert(next_seen[s]);
-				next_seen[s]=false;
+	//True if any of the changed transitions could affect this string's result
+	bool touchesChange(StringCache & c){
+		for(int i = 0;i<c.touched_labels.size();i++){
+			int l = c.touched_labels[i];
+			Bitset & states = c.touched[i];
+			for(int j = 0;j<changed_from.size();j++){
+				if(changed_label[j]==l && states[changed_from[j]])
+					return true;
 			}
-			next.clear();
 		}
+		return false;
+	}
 
-		//final emove pass:
-		if(g.emovesEnabled()){
-			for(int i = 0;i<accepts.size();i++){
-				int s = accepts[i];
+	//Collect the transitions that changed since the last update; returns false if they could not be determined.
+	bool collectChanges(){
+		changed_from.clear();
+		changed_label.clear();
+		if(last_history_clear != g.historyclears){
+			//the history was cleared; compare against the successor table instead.
+			for(int s = 0;s<n_states;s++){
 				for(int j = 0;j<g.nIncident(s);j++){
-					//now check if the label is active
 					int edgeID= g.incident(s,j).id;
 					int to = g.incident(s,j).node;
-					if(!cur_seen[to] && g.transitionEnabled(edgeID,0,0)){
-						cur_seen[to]=true;
-						accepts.push(to);
-						markUsed(edgeID,0,0);
+					for(int l = 0;l<n_labels;l++){
+						if(successors[l][s][to]!=g.transitionEnabled(edgeID,l,0)){
+							updateSuccessor(s,to,l);
+							changed_from.push(s);
+							changed_label.push(l);
+						}
 					}
-
 				}
 			}
+		}else{
+			for (int i = history_qhead; i < g.history.size(); i++) {
+				DynamicFSM::EdgeChange & ch = g.history[i];
+				if(ch.output!=0)
+					continue;
+				int from = g.getEdge(ch.id).from;
+				int to = g.getEdge(ch.id).to;
+				updateSuccessor(from,to,ch.input);
+				changed_from.push(from);
+				changed_label.push(ch.input);
+			}
 		}
-
-
+		return true;
 	}
 
 	bool path_rec(int s, int dest,int string,int str_pos,int emove_count, vec<NFATransition> & path){
@@ -271,186 +364,59 @@ public:
 			return;
 		}
 
-		static int iteration = 0;
-		int local_it = ++iteration;
-		stats_full_updates++;
-
-		if (last_deletion == g.deletions) {
-			stats_num_skipable_deletions++;
-		}
-
-
-
-		bool edgesAdded=false;
-		bool edgesRemoved=false;
-		bool usedTransitionRemoved=!hasUsed;
-
-		if (last_modification <= 0 || g.changed() || last_history_clear != g.historyclears) {
-			next_seen.clear();
-			next_seen.growTo(g.states());
-			cur_seen.clear();
-			cur_seen.growTo(g.states());
-			hasUsed=false;
-			if(checkUsed){
-				usedTransitions.growTo(g.nEdgeIDs() );
-				for(int i =0;i<g.nEdgeIDs();i++){
-					usedTransitions[i].growTo(g.inAlphabet()+1);
-
-				}
-			}
-			hasAcceptanceStates=false;
-			for(int i = 0;i<strings.size();i++){
-				for(int j = 0;j<states_were_accepting[i].size();j++)
-					states_were_accepting[i][j]=false;
-				//for(int j = 0;j<states_were_rejecting[i].size();j++)
-				//	states_were_rejecting[i][j]=false;
+		cache.growTo(strings.size());
+		if (last_modification <= 0 || g.changed() || g.states()!=n_states || g.inAlphabet()!=n_labels || g.emovesEnabled()!=had_emoves) {
+			stats_full_updates++;
+			buildSuccessors();
+			for(int str = 0;str<strings.size();str++){
+				cache[str].valid=false;
 			}
-			edgesAdded=true;
-			edgesRemoved=true;
-			usedTransitionRemoved=true;
-		}
-
-		//it should be safe to skip updates, under the following conditions
-		//1) if none of the removed transitions were traversed by the (relevant) accepting traces.
-		//2) if all of the changes are added edges, AND all of the properties we are checking are asserted positive
-		//3) if all of the changes are removed edges, AND all of the properties we are checking are asserted false.
-		//4) If no transitions removed edges, AND all strings that were previously accepted
-		//5) if no transitions added edges, AND all strings were previously rejected
-
-		//These checks can be done per-string, or as a whole.
-		for (int i = history_qhead; i < g.history.size(); i++) {
-			DynamicFSM::EdgeChange & c = g.history[i];
-			if(c.addition){
-				edgesAdded=true;
-			}else{
-				edgesRemoved=true;
-				if(hasUsed){
-					//if we are keeping track of which transitions were used, we can apply
-					usedTransitionRemoved|=usedTransitions[c.id][c.input];
+		}else{
+			stats_fast_updates++;
+			collectChanges();
+			if(changed_from.size()){
+				for(int str = 0;str<strings.size();str++){
+					if(cache[str].valid && (!trackUsed || touchesChange(cache[str]))){
+						cache[str].valid=false;
+					}
 				}
 			}
-
-			if(usedTransitionRemoved && edgesAdded && edgesRemoved)
-				break;
-		}
-
-/*
- 	 //not sure if these are safe, and they might be superseeded by the (slightly less efficient) check below, anyhow...
-		if(n_track_positive==0 && !edgesRemoved){
-			//we can skip this update, because no edges were removed, and we don't care if any strings were made positive
-			stats_skipped_updates++;
-			return;
-		}
-		if(n_track_negative==0 && !edgesAdded){
-			//we can skip this update, because no edges were added, and we don't care if any strings were made negative
-			stats_skipped_updates++;
-			return;
-		}*/
-
-
-
-
-
-
-		if(hasUsed){
-			//clear used
-			hasUsed=false;
-		/*	for(int i = 0;i<usedTransitions.size();i++){
-				for(int l = 0;l<usedTransitions[i].size()){
-					usedTransitions[i][l]=false;
-				}
-			}*/
 		}
 
-		//for(int i = 0;i<g.states();i++)
 		for (int str = 0;str<strings.size();str++){
 			if(n_trackingString[str]==0)
 				continue;
-			bool all_satisfied=false;
-			if(hasAcceptanceStates){
-				all_satisfied=true;
-				if(edgesAdded){
-					for(int i = 0;i<g.states();i++){
-						//If we are tracking the acceptance of this state, and it didn't previously accept this string, and we enabled an edge
-						//then we need to recompute acceptance
-						if(states_to_track_positive[str][i] && !states_were_accepting[str][i]){
-							all_satisfied=false;
-							break;
-						}
-
-						//If we are tracking the rejection of this state, and it previously accepted this string, and we removed an edge
-						//then we need to recompute acceptance
-						if(states_to_track_negative[str][i] && !states_were_accepting[str][i]){
-							all_satisfied=false;
-							break;
-						}
-					}
-				}
-				if(edgesRemoved && all_satisfied){
-					for(int i = 0;i<g.states();i++){
-
-						if(states_to_track_positive[str][i] && states_were_accepting[str][i]){
-							all_satisfied=false;
-							break;
-						}
-
-						if(states_to_track_negative[str][i] && states_were_accepting[str][i]){
-							all_satisfied=false;
-							break;
-						}
-					}
-				}
-
-			}
-			if(!all_satisfied){
-
-				find_accepts(str);
-				for(int i = 0;i<g.states();i++){
-					states_were_accepting[str][i]=false;
-				}
-				for(int s:accepts){
-					status.accepts(str,s,-1,-1,true);
-					states_were_accepting[str][s]=true;
-				}
-
-				//improve this:
-				for(int s = 0;s<g.states();s++){
-					if (!cur_seen[s]){
-						status.accepts(str,s,-1,-1,false);
-					}
-				}
+			StringCache & c = cache[str];
+			if(!c.valid){
+				simulate(str,&c);
 			}else{
-				for(int i = 0;i<g.states();i++){
-					status.accepts(str,i,-1,-1,states_were_accepting[str][i]);
-				}
+				stats_strings_cached++;
+			}
+			for(int s = 0;s<n_states;s++){
+				status.accepts(str,s,-1,-1,c.accepting[s]);
 			}
 		}
 
-		hasAcceptanceStates=true;
-
 		last_modification = g.modifications;
-		last_deletion = g.deletions;
-		last_addition = g.additions;
-
 		history_qhead = g.history.size();
 		last_history_clear = g.historyclears;
 	}
 
-
-
-
 public:
 	void run(int str){
-		next_seen.growTo(g.states());
-		cur_seen.growTo(g.states());
-		find_accepts(str);
+		if(g.states()!=n_states || g.inAlphabet()!=n_labels || g.emovesEnabled()!=had_emoves || last_modification!=g.modifications){
+			//run() may be called outside of update(), so rebuild the successor table
+			buildSuccessors();
+			last_modification=-1;
+		}
+		simulate(str,nullptr);
 	}
 	//If state is -1, then this is true if any state accepts the string.
 	bool accepting( int state){
 		if(state<0){
-			return accepts.size();
+			return cur.count()>0;
 		}
-		return cur_seen[state];
+		return cur[state];
 	}
 
 	//inefficient!
@@ -93,6 +93,23 @@ public:
 		return propagate(conflict);
 	}
 
+	//Optionally bring this detector's graph algorithms up to date before propagate() is called.
+	//Implementations may only read the shared graphs and assignment, and only write state owned by this detector,
+	//as this may be called concurrently for different detectors (see opt_graph_prop_threads).
+	//Returns true if the detector has any such work to do.
+	virtual bool prepareUpdate(){
+		return false;
+	}
+	//The number of independent parts that prepareUpdate() can be split into (see prepareUpdate(int)).
+	virtual int nPrepareParts(){
+		return 1;
+	}
+	//Bring just one part (0<=part<nPrepareParts()) of this detector up to date.
+	//Different parts of the same detector may also be prepared concurrently, so they must not share any mutable state.
+	virtual bool prepareUpdate(int part){
+		return prepareUpdate();
+	}
+
 	virtual void buildReason(Lit p, vec<Lit> & reason, CRef marker)=0;
 	virtual bool checkSatisfied()=0;
 	virtual void preprocess() {
@@ -781,6 +781,24 @@ void DistanceDetector<Weight>::preprocess() {
 
 
 
+template<typename Weight>
+bool DistanceDetector<Weight>::prepareUpdate() {
+	if (!underapprox_unweighted_distance_detector)
+		return false;
+	//updateShortestPaths() is left to propagate(), as it is only needed for the shortest path theory.
+	if (!opt_detect_pure_theory_lits || unassigned_positives > 0) {
+		double startdreachtime = rtime(2);
+		underapprox_unweighted_distance_detector->update();
+		stats_under_update_time += rtime(2) - startdreachtime;
+	}
+	if (!opt_detect_pure_theory_lits || unassigned_negatives > 0) {
+		double startunreachtime = rtime(2);
+		overapprox_unweighted_distance_detector->update();
+		stats_over_update_time += rtime(2) - startunreachtime;
+	}
+	return true;
+}
+
 template<typename Weight>
 bool DistanceDetector<Weight>::propagate(vec<Lit> & conflict) {
 	if (!underapprox_unweighted_distance_detector)
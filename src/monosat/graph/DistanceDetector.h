@@ -237,6 +237,7 @@ public:
 		}
 	}
 	void preprocess();
+	bool prepareUpdate();
 	bool propagate(vec<Lit> & conflict);
 	void buildUnweightedDistanceLEQReason(int node, vec<Lit> & conflict);
 	void buildUnweightedDistanceGTReason(int node, int within_steps, vec<Lit> & conflict);
@@ -85,6 +85,7 @@ class GraphParser: public Parser<B, Solver> {
 	vec<EdgePriority> edgePriorities;
 
 	vec<char> tmp;
+	vec<Var> edge_vars;
 	
 	struct BVEdge{
 		int graphID;
@@ -1029,6 +1030,38 @@ public:
 			precise(precise),bvTheory(bvTheory) {
 		
 	}
+	bool parseEdges(int graphID, const int32_t * from, const int32_t * to, const int32_t * edgeVars, const int64_t * weights, int n, Solver& S) {
+		if (opt_ignore_theories) {
+			return true;
+		}
+		if (graphID < 0 || graphID >= graphs.size()) {
+			parse_errorf("PARSE ERROR! Undeclared graph identifier %d for edge block\n", graphID);
+		}
+		edge_vars.clear();
+		for (int i = 0; i < n; i++) {
+			int edgeVar = edgeVars[i] - 1;
+			if (edgeVar < 0) {
+				parse_errorf("PARSE ERROR! Edge variables must be >=0, was %d\n", edgeVar);
+			}
+			edge_vars.push(mapVar(S, edgeVar));
+		}
+		if (graphs[graphID]) {
+			//the weights are already in the graph's own representation, so the whole block can be added at once
+			graphs[graphID]->newEdges(from, to, weights, edge_vars.begin(), n);
+		} else if (graphs_float[graphID]) {
+			for (int i = 0; i < n; i++) {
+				graphs_float[graphID]->newEdge(from[i], to[i], edge_vars[i], weights ? (double) weights[i] : 1.0);
+			}
+		} else if (graphs_rational[graphID]) {
+			for (int i = 0; i < n; i++) {
+				mpq_class weight(weights ? (long) weights[i] : 1L);
+				graphs_rational[graphID]->newEdge(from[i], to[i], edge_vars[i], weight);
+			}
+		} else {
+			parse_errorf("PARSE ERROR! Undeclared graph identifier %d for edge block\n", graphID);
+		}
+		return true;
+	}
 	bool parseLine(B& in, Solver& S) {
 		
 		skipWhitespace(in);
@@ -31,6 +31,7 @@
 
 #include "monosat/core/SolverTypes.h"
 #include "monosat/mtl/Map.h"
+#include "monosat/mtl/Sort.h"
 #include "monosat/dgl/MaxFlow.h"
 #include "monosat/dgl/DynamicGraph.h"
 #include "monosat/dgl/EdmondsKarp.h"
@@ -44,6 +45,7 @@
 #include "monosat/graph/WeightedDijkstra.h"
 #include "monosat/graph/GraphTheoryTypes.h"
 #include "monosat/utils/System.h"
+#include "monosat/utils/ThreadPool.h"
 #include "monosat/core/Solver.h"
 
 #include "monosat/graph/AllPairsDetector.h"
@@ -520,6 +522,8 @@ public:
 	vec<Edge> edge_list;
 	vec<vec<Edge> > undirected_adj;
 	vec<vec<Edge> > inv_adj;
+	//For each edge that has been merged into a parallel edge with an equivalent literal, the ID of that edge (else -1).
+	vec<int> edge_merged_into;
 
 	//vector of the weights for each edge
 	std::vector<Weight> edge_weights;
@@ -549,6 +553,13 @@ public:
 */
 
 	bool requiresPropagation = true;
+	//only allocated if opt_graph_prop_threads>0
+	ThreadPool * detector_pool = nullptr;
+	struct PrepareTask {
+		Detector * d;
+		int part;
+	};
+	vec<PrepareTask> detectors_to_prepare;
 	//int n_decisions = 0;
 	//vec<int> var_decision_pos;
 
@@ -599,6 +610,9 @@ public:
 	long stats_mc_calls = 0;
 	long stats_propagations_skipped = 0;
 	long stats_lazy_decisions = 0;
+	long stats_concurrent_updates = 0;
+	double stats_concurrent_update_time = 0;
+	long stats_merged_edges = 0;
 	vec<Lit> reach_cut;
 
 	struct CutStatus {
@@ -678,6 +692,11 @@ public:
 		g_under.dynamic_history_clears=opt_dynamic_history_clear;
 		g_over.dynamic_history_clears=opt_dynamic_history_clear;
 		cutGraph.dynamic_history_clears=opt_dynamic_history_clear;
+		g_under.use_csr=opt_graph_csr;
+		g_over.use_csr=opt_graph_csr;
+		g_under_weights_over.use_csr=opt_graph_csr;
+		g_over_weights_under.use_csr=opt_graph_csr;
+		cutGraph.use_csr=opt_graph_csr;
 		
 
 
@@ -720,6 +739,13 @@ public:
 		printf("Conflicts: %ld (lazy conflicts %ld)\n", stats_num_conflicts,stats_num_lazy_conflicts);
 		printf("Reasons: %ld (%f s, avg: %f s)\n", stats_num_reasons, stats_reason_time,
 				(stats_reason_time) / ((double) stats_num_reasons + 1));
+		if (detector_pool) {
+			printf("Concurrent detector updates: %ld (%d threads, %f s)\n", stats_concurrent_updates,
+					detector_pool->nThreads(), stats_concurrent_update_time);
+		}
+		if (opt_theory_equivalences) {
+			printf("Merged parallel edges: %ld\n", stats_merged_edges);
+		}
 
 		fflush(stdout);
 
@@ -775,8 +801,14 @@ public:
 		assert(!isEdgeVar(v));
 		return vars[v].detector_edge;
 	}
+	inline bool isMergedEdge(int edgeID) const {
+		return edgeID < edge_merged_into.size() && edge_merged_into[edgeID] >= 0;
+	}
 	
+	//Merged edges are represented by the variable of the edge they were merged into, whose assignment they share.
 	inline Var getEdgeVar(int edgeID) {
+		if (isMergedEdge(edgeID))
+			edgeID = edge_merged_into[edgeID];
 		Var v = edge_list[edgeID].v;
 		assert(v < vars.size());
 		assert(vars[v].isEdge);
@@ -1032,6 +1064,8 @@ public:
 	}
 	
 	~GraphTheorySolver() {
+		if (detector_pool)
+			delete detector_pool;
 	}
 
 	int newNode() {
@@ -1050,9 +1084,59 @@ public:
 		
 		return g_under.addNode();
 	}
-	void newNodes(int n) {
-		for (int i = 0; i < n; i++)
-			newNode();
+	//Add n nodes at once, returning the index of the first one; the graphs' histories are only invalidated once.
+	int newNodes(int n) {
+		int first = nNodes();
+		if (n <= 0)
+			return first;
+		inv_adj.growTo(first + n);
+		undirected_adj.growTo(first + n);
+		reach_info.growTo(first + n);
+		connect_info.growTo(first + n);
+		dist_info.growTo(first + n);
+		weighted_dist_info.growTo(first + n);
+		g_over.addNodes(n);
+		cutGraph.addNodes(n);
+		g_under_weights_over.addNodes(n);
+		g_over_weights_under.addNodes(n);
+		g_under.addNodes(n);
+		seen.growTo(nNodes());
+		return first;
+	}
+	//Reserve space for n more edges.
+	void reserveEdges(int n) {
+		edge_list.capacity(edge_list.size() + n);
+		edge_weights.reserve(edge_list.size() + n);
+		vars.capacity(vars.size() + n);
+		assigns.capacity(assigns.size() + n);
+		trail.capacity(trail.size() + n);
+		g_under.reserveEdges(n);
+		g_over.reserveEdges(n);
+		g_under_weights_over.reserveEdges(n);
+		g_over_weights_under.reserveEdges(n);
+		cutGraph.reserveEdges(2 * n);
+	}
+	/**
+	 * Add n edges at once (from[i] -> to[i], with weight weights[i], or 1 if weights is null), controlled by outerVars[i].
+	 * The edge history that adding an edge normally records is discarded in a single flush at the end.
+	 */
+	void newEdges(const int * from, const int * to, const Weight * weights, const Var * outerVars, int n) {
+		int max_node = -1;
+		for (int i = 0; i < n; i++) {
+			max_node = std::max(max_node, std::max(from[i], to[i]));
+		}
+		if (max_node >= nNodes())
+			newNodes(max_node + 1 - nNodes());
+		reserveEdges(n);
+		for (int i = 0; i < n; i++) {
+			newEdge(from[i], to[i], outerVars[i], weights ? weights[i] : Weight(1));
+		}
+		//the newly added edges have only just been created, so none of the algorithms need to see their history
+		g_under.clearHistory(true);
+		g_over.clearHistory(true);
+		g_under_weights_over.clearHistory(true);
+		g_over_weights_under.clearHistory(true);
+		cutGraph.clearHistory(true);
 	}
 	int nNodes() {
 		return g_under.nodes();
@@ -1114,7 +1198,10 @@ public:
 
 		if (opt_conflict_min_cut) {
 			for (int i = 0; i < edge_list.size(); i++) {
-				if (value(edge_list[i].v) == l_False) {
+				if (isMergedEdge(i)) {
+					assert(!cutGraph.edgeEnabled(i * 2));
+					assert(!cutGraph.edgeEnabled(i * 2 + 1));
+				} else if (value(edge_list[i].v) == l_False) {
 					assert(cutGraph.edgeEnabled(i * 2));
 					assert(!cutGraph.edgeEnabled(i * 2 + 1));
 				} else {
@@ -1124,7 +1211,7 @@ public:
 			}
 		}
 		for (int i = 0; i < edge_list.size(); i++) {
-			if (edge_list[i].v < 0)
+			if (edge_list[i].v < 0 || isMergedEdge(i))
 				continue;
 			Edge & e = edge_list[i];
 			lbool val = value(e.v);
@@ -1266,7 +1353,9 @@ public:
 		Var v = var(l);
 		assert(value(l)==l_True);
 		lbool assign = sign(l)?l_False:l_True;
-			if (isEdgeVar(v)) {
+			if (isEdgeVar(v) && isMergedEdge(getEdgeID(v))) {
+				//merged edges are never enabled or disabled in the graphs
+			} else if (isEdgeVar(v)) {
 				int edge_num = getEdgeID(v); //e.var-min_edge_var;
 				assert(assigns[v]!=l_Undef);
 
@@ -1663,7 +1752,7 @@ public:
 	bool dbg_graphsUpToDate() {
 #ifdef DEBUG_GRAPH
 		for(int i = 0;i<edge_list.size();i++) {
-			if(edge_list[i].v<0)
+			if(edge_list[i].v<0 || isMergedEdge(i))
 			continue;
 			Edge e = edge_list[i];
 			lbool val = value(e.v);
@@ -1722,6 +1811,111 @@ public:
 	 return edge_num;
 	 }*/
 
+	//Parallel edges with equivalent literals can only be merged if every detector ignores edge multiplicity
+	//(as reachability and shortest paths do, but maximum flows, spanning trees and undirected cycles do not).
+	bool canMergeEdges() const {
+		return !has_any_bitvector_edges && !using_neg_weights
+				&& detectors.size()
+						== reach_detectors.size() + distance_detectors.size() + weighted_distance_detectors.size();
+	}
+
+	//Collapse parallel edges of the same weight whose literals the SAT solver has proven equivalent into a single edge
+	//of the dynamic graphs. The merged edge is left disabled in every graph, and is explained by the variable of the
+	//edge it was merged into (see getEdgeVar), so the detectors track, update and explain one edge in place of many.
+	void mergeEquivalentAtoms() override {
+		if (!canMergeEdges()) {
+			unmergeEdges();
+			return;
+		}
+		edge_merged_into.growTo(edge_list.size(), -1);
+		vec<Lit> rep_lits;
+		rep_lits.growTo(edge_list.size(), lit_Undef);
+		vec<int> candidates;
+		for (int edgeID = 0; edgeID < edge_list.size(); edgeID++) {
+			Edge & e = edge_list[edgeID];
+			if (e.v == var_Undef || e.from == e.to || isMergedEdge(edgeID) || value(e.v) != l_Undef || hasTheory(e.v))
+				continue;
+			rep_lits[edgeID] = S->getEquivalentLit(toSolver(mkLit(e.v)));
+			candidates.push(edgeID);
+		}
+		auto parallel = [&](int a, int b) {
+			return edge_list[a].from == edge_list[b].from && edge_list[a].to == edge_list[b].to
+					&& rep_lits[a] == rep_lits[b] && edge_weights[a] == edge_weights[b];
+		};
+		sort(candidates, [&](int a, int b) {
+			if (edge_list[a].from != edge_list[b].from)
+				return edge_list[a].from < edge_list[b].from;
+			if (edge_list[a].to != edge_list[b].to)
+				return edge_list[a].to < edge_list[b].to;
+			if (rep_lits[a] != rep_lits[b])
+				return rep_lits[a] < rep_lits[b];
+			if (edge_weights[a] != edge_weights[b])
+				return edge_weights[a] < edge_weights[b];
+			return a < b;
+		});
+		for (int i = 0; i < candidates.size();) {
+			int rep = candidates[i++];
+			while (i < candidates.size() && parallel(rep, candidates[i])) {
+				mergeEdge(candidates[i++], rep);
+			}
+		}
+	}
+
+	void mergeEdge(int edgeID, int intoEdgeID) {
+		assert(!isMergedEdge(edgeID) && !isMergedEdge(intoEdgeID));
+		assert(value(edge_list[edgeID].v) == l_Undef);
+		edge_merged_into[edgeID] = intoEdgeID;
+		stats_merged_edges++;
+		Edge & e = edge_list[edgeID];
+		removeAdjacency(inv_adj[e.to], edgeID);
+		removeAdjacency(undirected_adj[e.to], edgeID);
+		removeAdjacency(undirected_adj[e.from], edgeID);
+		g_over.disableEdge(edgeID);
+		if (opt_conflict_min_cut) {
+			cutGraph.disableEdge(edgeID * 2 + 1);
+		}
+	}
+
+	//Restore all merged edges, as separate edges in the graphs that follow their own assignments.
+	void unmergeEdges() {
+		for (int edgeID = 0; edgeID < edge_merged_into.size(); edgeID++) {
+			if (!isMergedEdge(edgeID))
+				continue;
+			edge_merged_into[edgeID] = -1;
+			Edge & e = edge_list[edgeID];
+			undirected_adj[e.to].push( { e.v, e.outerVar, e.from, e.to, edgeID });
+			undirected_adj[e.from].push( { e.v, e.outerVar, e.to, e.from, edgeID });
+			inv_adj[e.to].push( { e.v, e.outerVar, e.from, e.to, edgeID });
+			lbool val = value(e.v);
+			if (val == l_True) {
+				g_under.enableEdge(edgeID);
+			}
+			if (val != l_False) {
+				g_over.enableEdge(edgeID);
+			}
+			if (opt_conflict_min_cut) {
+				cutGraph.enableEdge(val == l_False ? edgeID * 2 : edgeID * 2 + 1);
+			}
+			if (using_neg_weights) {
+				g_under_weights_over.setEdgeEnabled(edgeID, val == l_True);
+				g_over_weights_under.setEdgeEnabled(edgeID, val != l_False);
+			}
+			if (val != l_Undef) {
+				g_under.makeEdgeAssignmentConstant(edgeID);
+				g_over.makeEdgeAssignmentConstant(edgeID);
+			}
+		}
+	}
+
+	static void removeAdjacency(vec<Edge> & adj, int edgeID) {
+		int i, j;
+		for (i = j = 0; i < adj.size(); i++) {
+			if (adj[i].edgeID != edgeID)
+				adj[j++] = adj[i];
+		}
+		adj.shrink(i - j);
+	}
+
 	void preprocess() {
 
 		for (int i = 0; i < detectors.size(); i++) {
@@ -1822,7 +2016,9 @@ public:
 			bool assign = sign(l);//intentionally inverting this compared to what it normally would be, because l is currently assigned with the opposite polarity in the theory solver
 			assigns[v] = l_Undef;
 			//on_trail=true;
-			if (isEdgeVar(v)) {
+			if (isEdgeVar(v) && isMergedEdge(getEdgeID(v))) {
+				//merged edges are never enabled or disabled in the graphs
+			} else if (isEdgeVar(v)) {
 				int edge_num = getEdgeID(v); //e.var-min_edge_var;
 				if (assign) {
 					g_under.disableEdge( edge_num);
@@ -1880,7 +2076,9 @@ public:
 			return;
 		}
 
-		if (isEdgeVar(var(l))) {
+		if (isEdgeVar(var(l)) && isMergedEdge(getEdgeID(var(l)))) {
+			//this edge was merged into a parallel edge with an equivalent literal, which stands in for it in the graphs
+		} else if (isEdgeVar(var(l))) {
 			
 			//this is an edge assignment
 			int edge_num = getEdgeID(var(l)); //v-min_edge_var;
@@ -2044,6 +2242,10 @@ public:
 		dbg_sync();
 		assert(dbg_graphsUpToDate());
 
+		if (opt_graph_prop_threads > 0 && detectors.size() > 0) {
+			prepareDetectorsConcurrently();
+		}
+
 		for (int d = 0; d < detectors.size(); d++) {
 			assert(conflict.size() == 0);
 			Lit l = lit_Undef;
@@ -2196,6 +2398,42 @@ public:
 		return true;
 	}
 
+	/**
+	 * Bring the graph algorithms of each detector up to date concurrently, on a pool of worker threads.
+	 * This phase only reads g_under/g_over and the current assignment; each detector records its changes locally.
+	 * The sequential detector loop in propagateTheory then enqueues implied literals and reports conflicts
+	 * in order of detector ID exactly as it would without threads, so that results remain reproducible.
+	 * Detectors that maintain several independent algorithms (e.g., the under and over approximate maximum flows)
+	 * are split into parts, so that even a single such detector can make use of more than one thread.
+	 */
+	void prepareDetectorsConcurrently(){
+		double start_time = rtime(1);
+		if (!detector_pool) {
+			detector_pool = new ThreadPool(opt_graph_prop_threads);
+		}
+		detectors_to_prepare.clear();
+		for (Detector * d : detectors) {
+			if (d->unassigned_positives > 0 || d->unassigned_negatives > 0 || !opt_detect_pure_theory_lits) {
+				for (int part = 0; part < d->nPrepareParts(); part++) {
+					detectors_to_prepare.push( { d, part });
+				}
+			}
+		}
+		if (detectors_to_prepare.size() > 1) {
+			stats_concurrent_updates++;
+			//the adjacency snapshots are rebuilt lazily, so make sure that doesn't happen inside the worker threads.
+			g_under.updateSnapshot();
+			g_over.updateSnapshot();
+			g_under_weights_over.updateSnapshot();
+			g_over_weights_under.updateSnapshot();
+			cutGraph.updateSnapshot();
+			detector_pool->parallel_for(detectors_to_prepare.size(), [&](int i) {
+				detectors_to_prepare[i].d->prepareUpdate(detectors_to_prepare[i].part);
+			});
+		}
+		stats_concurrent_update_time += rtime(1) - start_time;
+	}
+
 	bool supportsLazyBacktracking(){
 		return lazy_backtracking_enabled;
 	}
@@ -2275,6 +2513,12 @@ public:
 			if (val == l_Undef) {
 				return false;
 			}
+			if (isMergedEdge(i)) {
+				if (val != value(getEdgeVar(i))) {
+					return false;
+				}
+				continue;
+			}
 			
 			if (val == l_True) {
 				/*	if(!g.hasEdge(e.from,e.to)){
@@ -778,14 +778,21 @@ void MaxflowDetector<Weight>::buildReason(Lit p, vec<Lit> & reason, CRef marker)
 		 }*/
 		Var v = var(p);
 		DistLit & f = flow_lits[reach_lit_map[v - first_reach_var]];
-		if (f.max_flow>=0){
-			Weight flow = f.max_flow;
-			//int u =getNode(v);
-			buildMaxFlowTooHighReason(flow, reason);
-		}else{
+		if (f.max_flow<0){
 			auto & bv= f.bv;
 			outer->buildBVReason(bv.getID(),f.inclusive ? Comparison::gt:Comparison::geq,bv.getUnder(),reason);
-			buildMaxFlowTooHighReason(bv.getOver(), reason);
+		}
+		if (!loadCachedReason(under_reason_cache, reason)) {
+			int from = reason.size();
+			double startreasontime = rtime(2);
+			if (f.max_flow>=0){
+				Weight flow = f.max_flow;
+				//int u =getNode(v);
+				buildMaxFlowTooHighReason(flow, reason);
+			}else{
+				buildMaxFlowTooHighReason(f.bv.getOver(), reason);
+			}
+			storeCachedReason(under_reason_cache, reason, from, rtime(2) - startreasontime);
 		}
 		//double elapsed = rtime(2)-startpathtime;
 		//	pathtime+=elapsed;
@@ -800,21 +807,96 @@ void MaxflowDetector<Weight>::buildReason(Lit p, vec<Lit> & reason, CRef marker)
 		
 		Var v = var(p);
 		DistLit & f = flow_lits[reach_lit_map[v - first_reach_var]];
-		if (f.max_flow>=0){
-			Weight flow = f.max_flow;
-			//int t = getNode(v); // v- var(reach_lits[d][0]);
-			buildMaxFlowTooLowReason(flow, reason);
-		}else{
+		if (f.max_flow<0){
 			auto & bv = f.bv;
 			outer->buildBVReason(bv.getID(),f.inclusive ? Comparison::gt:Comparison::geq,bv.getUnder(),reason);
-			//int t = getNode(v); // v- var(reach_lits[d][0]);
-			buildMaxFlowTooLowReason(bv.getUnder(), reason);
+		}
+		if (!loadCachedReason(over_reason_cache, reason)) {
+			int from = reason.size();
+			double startreasontime = rtime(2);
+			if (f.max_flow>=0){
+				Weight flow = f.max_flow;
+				//int t = getNode(v); // v- var(reach_lits[d][0]);
+				buildMaxFlowTooLowReason(flow, reason);
+			}else{
+				//int t = getNode(v); // v- var(reach_lits[d][0]);
+				buildMaxFlowTooLowReason(f.bv.getUnder(), reason);
+			}
+			storeCachedReason(over_reason_cache, reason, from, rtime(2) - startreasontime);
 		}
 		
 	} else {
 		assert(false);
 	}
 }
+/**
+ * If the graph is unchanged since the cached explanation was built, append it to the reason and return true.
+ * Every cached literal must still be false (the edge and bitvector assignments it relies on may have been
+ * undone and re-derived differently, without changing the graph itself); otherwise the cache is discarded.
+ */
+template<typename Weight>
+bool MaxflowDetector<Weight>::loadCachedReason(ReasonCache & cache, vec<Lit> & reason) {
+	if (!opt_maxflow_reason_cache || !reasonCacheCurrent(cache))
+		return false;
+	for (Lit l : cache.lits) {
+		if (outer->value(l) != l_False) {
+			cache.valid = false;
+			return false;
+		}
+	}
+	for (Lit l : cache.lits)
+		reason.push(l);
+	bumpConflictEdges(reason);
+	stats_reason_cache_hits++;
+	stats_reason_cache_saved_time += cache.build_time;
+	return true;
+}
+
+template<typename Weight>
+void MaxflowDetector<Weight>::storeCachedReason(ReasonCache & cache, vec<Lit> & reason, int from, double build_time) {
+	if (!opt_maxflow_reason_cache)
+		return;
+	stats_reason_cache_misses++;
+	cache.lits.clear();
+	for (int i = from; i < reason.size(); i++)
+		cache.lits.push(reason[i]);
+	cache.under_modifications = g_under.modifications;
+	cache.over_modifications = g_over.modifications;
+	cache.build_time = build_time;
+	cache.valid = true;
+}
+
+template<typename Weight>
+bool MaxflowDetector<Weight>::prepareUpdate() {
+	bool any = prepareUpdate(0);
+	return prepareUpdate(1) || any;
+}
+
+template<typename Weight>
+bool MaxflowDetector<Weight>::prepareUpdate(int part) {
+	if (flow_lits.size() == 0) {
+		return false;
+	}
+	//The maxflow algorithms cache their result until the graph is next modified, so propagate() will
+	//not repeat this work.
+	//The under and over approximate flows are computed by separate algorithms on separate graphs,
+	//so the two parts may be prepared concurrently.
+	if (part == 0) {
+		if (underapprox_detector && (!opt_detect_pure_theory_lits || unassigned_positives > 0)) {
+			double startdreachtime = rtime(2);
+			underapprox_detector->maxFlow();
+			stats_under_update_time += rtime(2) - startdreachtime;
+			return true;
+		}
+	} else if (overapprox_detector && (!opt_detect_pure_theory_lits || unassigned_negatives > 0)) {
+		double startunreachtime = rtime(2);
+		overapprox_detector->maxFlow();
+		stats_over_update_time += rtime(2) - startunreachtime;
+		return true;
+	}
+	return false;
+}
+
 template<typename Weight>
 bool MaxflowDetector<Weight>::propagate(vec<Lit> & conflict, bool backtrackOnly, Lit & conflictLit) {
 	if (flow_lits.size() == 0) {
@@ -26,6 +26,7 @@
 #include "monosat/dgl/DynamicGraph.h"
 #include "monosat/dgl/MaxFlow.h"
 #include "monosat/dgl/EdmondsKarp.h"
+#include "monosat/dgl/EdmondsKarpDynamic.h"
 #include "monosat/core/SolverTypes.h"
 #include "monosat/mtl/Map.h"
 #include "monosat/mtl/Deque.h"
@@ -118,11 +119,36 @@ public:
 	vec<bool> seen;
 	vec<bool> seen_path;
 
+	//The explanation of a flow literal depends only on the graph (and not on the flow threshold of that literal),
+	//so all the flow literals propagated from the same graph state can share one explanation.
+	//Conflict analysis typically asks for several of these in a row; the graph part of the most recent
+	//explanation in each direction is kept here, along with the graph modification counts it was built at.
+	struct ReasonCache {
+		bool valid = false;
+		int under_modifications = -1;
+		int over_modifications = -1;
+		double build_time = 0;
+		vec<Lit> lits;
+	};
+	ReasonCache under_reason_cache;
+	ReasonCache over_reason_cache;
+	long stats_reason_cache_hits = 0;
+	long stats_reason_cache_misses = 0;
+	double stats_reason_cache_saved_time = 0;
+
+	inline bool reasonCacheCurrent(const ReasonCache & cache) const {
+		return cache.valid && cache.under_modifications == g_under.modifications
+				&& cache.over_modifications == g_over.modifications;
+	}
 
 	void backtrack(int level) override {
 		to_decide.clear();
 		last_decision_status = -1;
 		has_flow_model=false;
+		if (!reasonCacheCurrent(under_reason_cache))
+			under_reason_cache.valid = false;
+		if (!reasonCacheCurrent(over_reason_cache))
+			over_reason_cache.valid = false;
 		//LevelDetector::backtrack(level);
 	}
 	void collectChangedEdges();
@@ -137,12 +163,19 @@ public:
 
 
 	bool propagate(vec<Lit> & conflict, bool backtrackOnly, Lit & conflictLit);
+	bool prepareUpdate();
+	int nPrepareParts() override{
+		return 2;
+	}
+	bool prepareUpdate(int part) override;
 	void buildMaxFlowTooHighReason(Weight flow, vec<Lit> & conflict);
 	Lit findFirstReasonTooHigh(Weight flow);
 	Lit findFirstReasonTooLow(Weight flow);
 	void buildMaxFlowTooLowReason(Weight flow, vec<Lit> & conflict, bool force_maxflow = false);
 	void buildForcedEdgeReason(int reach_node, int forced_edge_id, vec<Lit> & conflict);
 	void buildReason(Lit p, vec<Lit> & reason, CRef marker);
+	bool loadCachedReason(ReasonCache & cache, vec<Lit> & reason);
+	void storeCachedReason(ReasonCache & cache, vec<Lit> & reason, int from, double build_time);
 	bool checkSatisfied();
 	bool decideEdgeWeight(int edgeID, Weight & store, DetectorComparison & op);
 	void undecideEdgeWeight(int edgeID);
@@ -163,13 +196,25 @@ public:
 					kt->stats_flow_calcs, kt->stats_flow_time, kt->stats_calc_time, kt->stats_inits, kt->stats_reinits);
 		} else
 			printf("\tDecision flow calculations: %ld\n", stats_decision_calculations);
+		EdmondsKarpDynamic<Weight> * ek_under = dynamic_cast<EdmondsKarpDynamic<Weight> *>(underapprox_detector);
+		EdmondsKarpDynamic<Weight> * ek_over = dynamic_cast<EdmondsKarpDynamic<Weight> *>(overapprox_detector);
+		if (ek_under && ek_over) {
+			printf("\tFull flow calculations: %ld (under), %ld (over), warm restarts: %ld (under), %ld (over)\n",
+					ek_under->stats_full_calcs, ek_over->stats_full_calcs, ek_under->stats_warm_restarts,
+					ek_over->stats_warm_restarts);
+		}
 		if(n_stats_priority_decisions>0){
 			printf("\tPriority decisions: %ld\n",n_stats_priority_decisions);
 		}
 		if(opt_theory_internal_vsids){
 			printf("\tVsids decisions: %ld\n",n_stats_vsids_decisions);
 		}
-		
+		if (opt_maxflow_reason_cache && (stats_reason_cache_hits + stats_reason_cache_misses) > 0) {
+			printf("\tReason cache: %ld hits, %ld misses (%.1f%% hit rate), %fs saved\n", stats_reason_cache_hits,
+					stats_reason_cache_misses,
+					100.0 * stats_reason_cache_hits / (double) (stats_reason_cache_hits + stats_reason_cache_misses),
+					stats_reason_cache_saved_time);
+		}
 	}
 	//Lit decideByPath(int level);
 	void dbg_decisions();
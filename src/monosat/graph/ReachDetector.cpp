@@ -19,6 +19,7 @@
  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  **************************************************************************************************/
 #include "monosat/dgl/RamalReps.h"
+#include "monosat/dgl/DynamicReach.h"
 #include "GraphTheory.h"
 #include "monosat/dgl/TarjansSCC.h"
 using namespace Monosat;
@@ -147,6 +148,24 @@ ReachDetector<Weight>::ReachDetector(int _detectorID, GraphTheorySolver<Weight>
 		}
 		overapprox_path_detector = overapprox_reach_detector;// new UnweightedBFS<Weight,Distance<int>::NullStatus>(from, _antig, Distance<int>::nullStatus, -1);
 		negative_distance_detector = (Distance<int> *) overapprox_path_detector;
+	} else if (reachalg == ReachAlg::ALG_DYNAMIC) {
+		if (!opt_encode_reach_underapprox_as_sat) {
+			underapprox_detector = new DynamicReachability<Weight,ReachDetector<Weight>::ReachStatus>(from, _g,
+					*(positiveReachStatus), 1);
+		} else {
+			underapprox_fast_detector = new DynamicReachability<Weight,ReachDetector<Weight>::ReachStatus>(from, _g,
+					*(positiveReachStatus), 1);
+		}
+
+		overapprox_reach_detector = new DynamicReachability<Weight,ReachDetector<Weight>::ReachStatus>(from, _antig,
+				*(negativeReachStatus), -1);
+		if (opt_conflict_shortest_path)
+			underapprox_path_detector = new UnweightedRamalReps<Weight,Reach::NullStatus>(from, _g, Reach::nullStatus, 0);
+		else if (underapprox_detector)
+			underapprox_path_detector = underapprox_detector;
+		else
+			underapprox_path_detector = underapprox_fast_detector;
+		overapprox_path_detector = overapprox_reach_detector;
 	}/*else if (reachalg==ReachAlg::ALG_THORUP){
 
 
@@ -1061,6 +1080,26 @@ void ReachDetector<Weight>::buildReason(Lit p, vec<Lit> & reason, CRef marker) {
 		assert(false);
 	}
 }
+template<typename Weight>
+bool ReachDetector<Weight>::prepareUpdate() {
+	//Only reads the graphs; any changed reach lits are recorded in this detector's own 'changed' list,
+	//and will be processed (in order) by the subsequent call to propagate().
+	bool any_work = false;
+	if (underapprox_detector && (!opt_detect_pure_theory_lits || unassigned_positives > 0)) {
+		double startdreachtime = rtime(2);
+		underapprox_detector->update();
+		stats_under_update_time += rtime(2) - startdreachtime;
+		any_work = true;
+	}
+	if (overapprox_reach_detector && (!opt_detect_pure_theory_lits || unassigned_negatives > 0)) {
+		double startunreachtime = rtime(2);
+		overapprox_reach_detector->update();
+		stats_over_update_time += rtime(2) - startunreachtime;
+		any_work = true;
+	}
+	return any_work;
+}
+
 template<typename Weight>
 bool ReachDetector<Weight>::propagate(vec<Lit> & conflict) {
 	static int iter = 0;
@@ -268,6 +268,7 @@ public:
 	 }*/
 
 	void buildSATConstraints(bool onlyUnderApprox = false, int within_steps = -1);
+	bool prepareUpdate();
 	bool propagate(vec<Lit> & conflict);
 	void buildReachReason(int node, vec<Lit> & conflict);
 	void buildNonReachReason(int node, vec<Lit> & conflict, bool force_maxflow = false);
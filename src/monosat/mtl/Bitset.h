@@ -28,7 +28,8 @@
 namespace Monosat {
 
 //=================================================================================================
-#define BITSET_ELEMENT_SIZE (sizeof(uint64_t))
+//number of bits in each element of the buffer
+#define BITSET_ELEMENT_SIZE (sizeof(uint64_t)*8)
 class Bitset {
     vec<uint64_t>  buf;
     int sz;
@@ -77,6 +78,11 @@ public:
     }
     int  size  () const { return sz; }
 
+    //Direct access to the underlying 64-bit words, for word-parallel algorithms
+    int nWords() const { return buf.size(); }
+    uint64_t getWord(int i) const { return buf[i]; }
+    void setWord(int i, uint64_t w) { buf[i]=w; }
+
 private:
 	static int popcount(uint64_t i){
 		//http://stackoverflow.com/a/2709523
@@ -115,7 +121,7 @@ public:
     	int i = index/BITSET_ELEMENT_SIZE ;
     	int rem = index % BITSET_ELEMENT_SIZE;
     	assert(i<buf.size());
-    	return buf[i] & (1<<rem);
+    	return (buf[i] >> rem) & 1;
     }
 
     inline void set(int index){
@@ -123,7 +129,7 @@ public:
     	int i = index/BITSET_ELEMENT_SIZE;
     	int r = index %BITSET_ELEMENT_SIZE;
 
-    	buf[i]|=(1<<r);
+    	buf[i]|=((uint64_t)1<<r);
 
     }
     inline void clear(int index){
@@ -131,7 +137,7 @@ public:
     	int i = index/BITSET_ELEMENT_SIZE;
     	int r = index %BITSET_ELEMENT_SIZE;
 
-    	buf[i]&= ~(1<<r);
+    	buf[i]&= ~((uint64_t)1<<r);
 
     }
     inline void toggle(int index){
@@ -139,7 +145,7 @@ public:
     	int i = index/BITSET_ELEMENT_SIZE;
     	int r = index %BITSET_ELEMENT_SIZE;
 
-    	buf[i]^= (1<<r);
+    	buf[i]^= ((uint64_t)1<<r);
 
     }
 	bool equals(Bitset & c){
@@ -0,0 +1,560 @@
+/****************************************************************************************[WideInt.h]
+ The MIT License (MIT)
+
+ Copyright (c) 2014, Sam Bayless
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ associated documentation files (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or
+ substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **************************************************************************************************/
+//Fixed-width integers, stored as a compile-time fixed array of 64-bit limbs.
+
+#ifndef WIDEINT_H_
+#define WIDEINT_H_
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace Monosat {
+
+/**
+ * A signed, two's complement integer of Limbs*64 bits.
+ * Arithmetic wraps around on overflow (as for unsigned machine integers), and shifts, division and
+ * comparisons follow the semantics of int64_t, so WideInt<1> behaves like int64_t.
+ *
+ * Unlike mpq_class, values never allocate, and all operations are straight-line loops over the limbs,
+ * so this is much faster than rational arithmetic for weights that need more than 63 bits.
+ */
+template<int Limbs>
+class WideInt {
+	static_assert(Limbs >= 1, "WideInt requires at least one limb");
+	uint64_t limb[Limbs];//least significant limb first
+
+	//Full 64x64->128 bit product, as (hi,lo)
+	static inline void mul64(uint64_t a, uint64_t b, uint64_t & hi, uint64_t & lo) {
+#ifdef __SIZEOF_INT128__
+		unsigned __int128 p = (unsigned __int128) a * b;
+		lo = (uint64_t) p;
+		hi = (uint64_t) (p >> 64);
+#else
+		uint64_t a_lo = (uint32_t) a, a_hi = a >> 32;
+		uint64_t b_lo = (uint32_t) b, b_hi = b >> 32;
+		uint64_t p0 = a_lo * b_lo;
+		uint64_t p1 = a_lo * b_hi;
+		uint64_t p2 = a_hi * b_lo;
+		uint64_t p3 = a_hi * b_hi;
+		uint64_t mid = (p0 >> 32) + (uint32_t) p1 + (uint32_t) p2;
+		lo = (mid << 32) | (uint32_t) p0;
+		hi = p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+#endif
+	}
+
+	//Divide the 128 bit value (hi,lo) by d, where hi<d; returns the quotient and stores the remainder.
+	static inline uint64_t div128(uint64_t hi, uint64_t lo, uint64_t d, uint64_t & rem) {
+#ifdef __SIZEOF_INT128__
+		unsigned __int128 n = ((unsigned __int128) hi << 64) | lo;
+		rem = (uint64_t) (n % d);
+		return (uint64_t) (n / d);
+#else
+		uint64_t q = 0;
+		for (int i = 63; i >= 0; i--) {
+			bool carry = hi >> 63;
+			hi = (hi << 1) | (lo >> 63);
+			lo <<= 1;
+			if (carry || hi >= d) {
+				hi -= d;
+				q |= ((uint64_t) 1) << i;
+			}
+		}
+		rem = hi;
+		return q;
+#endif
+	}
+
+	void fill(int64_t v) {
+		limb[0] = (uint64_t) v;
+		uint64_t ext = v < 0 ? ~(uint64_t) 0 : 0;
+		for (int i = 1; i < Limbs; i++)
+			limb[i] = ext;
+	}
+	void fillUnsigned(uint64_t v) {
+		limb[0] = v;
+		for (int i = 1; i < Limbs; i++)
+			limb[i] = 0;
+	}
+
+	//Number of significant limbs of a non-negative value
+	int usedLimbs() const {
+		int n = Limbs;
+		while (n > 0 && limb[n - 1] == 0)
+			n--;
+		return n;
+	}
+
+	//Unsigned comparison
+	static bool ult(const WideInt & a, const WideInt & b) {
+		for (int i = Limbs - 1; i >= 0; i--)
+			if (a.limb[i] != b.limb[i])
+				return a.limb[i] < b.limb[i];
+		return false;
+	}
+
+	//Unsigned division; quotient and remainder may alias neither argument.
+	static void udivmod(const WideInt & n, const WideInt & d, WideInt & q, WideInt & r) {
+		int dn = d.usedLimbs();
+		if (dn == 0)
+			throw std::domain_error("WideInt division by zero");
+		q = WideInt();
+		r = WideInt();
+		if (dn == 1) {
+			//short division, one limb at a time
+			uint64_t rem = 0;
+			for (int i = n.usedLimbs() - 1; i >= 0; i--) {
+				q.limb[i] = div128(rem, n.limb[i], d.limb[0], rem);
+			}
+			r.limb[0] = rem;
+			return;
+		}
+		if (ult(n, d)) {
+			r = n;
+			return;
+		}
+		//shift-subtract long division over the significant bits of the numerator
+		for (int i = n.highestBit(); i >= 0; i--) {
+			r <<= 1;
+			if (n.testBit(i))
+				r.limb[0] |= 1;
+			if (!ult(r, d)) {
+				r -= d;
+				q.setBit(i);
+			}
+		}
+	}
+
+public:
+	static constexpr int bits = Limbs * 64;
+
+	WideInt() {
+		for (int i = 0; i < Limbs; i++)
+			limb[i] = 0;
+	}
+	WideInt(int v) {
+		fill(v);
+	}
+	WideInt(long v) {
+		fill(v);
+	}
+	WideInt(long long v) {
+		fill(v);
+	}
+	WideInt(unsigned int v) {
+		fillUnsigned(v);
+	}
+	WideInt(unsigned long v) {
+		fillUnsigned(v);
+	}
+	WideInt(unsigned long long v) {
+		fillUnsigned(v);
+	}
+	template<int M>
+	explicit WideInt(const WideInt<M> & o) {
+		uint64_t ext = o.isNegative() ? ~(uint64_t) 0 : 0;
+		for (int i = 0; i < Limbs; i++)
+			limb[i] = i < M ? o.getLimb(i) : ext;
+	}
+	//Parse a decimal string, with an optional leading '-'.
+	explicit WideInt(const std::string & s) {
+		*this = fromString(s.c_str());
+	}
+
+	static WideInt fromString(const char * s) {
+		WideInt r;
+		bool neg = false;
+		if (*s == '-') {
+			neg = true;
+			s++;
+		} else if (*s == '+') {
+			s++;
+		}
+		if (*s < '0' || *s > '9')
+			throw std::invalid_argument("WideInt: not a number");
+		for (; *s >= '0' && *s <= '9'; s++) {
+			r *= 10;
+			r += (int) (*s - '0');
+		}
+		return neg ? -r : r;
+	}
+
+	//2^i
+	static WideInt bit(int i) {
+		WideInt r;
+		if (i >= 0 && i < bits)
+			r.limb[i / 64] = ((uint64_t) 1) << (i % 64);
+		return r;
+	}
+	//2^width - 1
+	static WideInt mask(int width) {
+		WideInt r;
+		if (width <= 0)
+			return r;
+		if (width >= bits)
+			return ~r;
+		int full = width / 64;
+		for (int i = 0; i < full; i++)
+			r.limb[i] = ~(uint64_t) 0;
+		if (width % 64)
+			r.limb[full] = (((uint64_t) 1) << (width % 64)) - 1;
+		return r;
+	}
+
+	inline uint64_t getLimb(int i) const {
+		return limb[i];
+	}
+	inline void setLimb(int i, uint64_t v) {
+		limb[i] = v;
+	}
+	inline bool testBit(int i) const {
+		return (limb[i / 64] >> (i % 64)) & 1;
+	}
+	inline void setBit(int i) {
+		limb[i / 64] |= ((uint64_t) 1) << (i % 64);
+	}
+	inline void clearBit(int i) {
+		limb[i / 64] &= ~(((uint64_t) 1) << (i % 64));
+	}
+	inline bool isNegative() const {
+		return limb[Limbs - 1] >> 63;
+	}
+	inline bool isZero() const {
+		for (int i = 0; i < Limbs; i++)
+			if (limb[i])
+				return false;
+		return true;
+	}
+	//Index of the highest set bit, or -1 if the value is zero.
+	int highestBit() const {
+		for (int i = Limbs - 1; i >= 0; i--) {
+			if (limb[i])
+				return i * 64 + 63 - __builtin_clzll(limb[i]);
+		}
+		return -1;
+	}
+	//True if the value can be represented exactly as an int64_t.
+	bool fitsInt64() const {
+		uint64_t ext = ((int64_t) limb[0]) < 0 ? ~(uint64_t) 0 : 0;
+		for (int i = 1; i < Limbs; i++)
+			if (limb[i] != ext)
+				return false;
+		return true;
+	}
+
+	explicit operator bool() const {
+		return !isZero();
+	}
+	//Truncates to the low 64 bits.
+	explicit operator long() const {
+		return (long) limb[0];
+	}
+	explicit operator long long() const {
+		return (long long) limb[0];
+	}
+	explicit operator int() const {
+		return (int) limb[0];
+	}
+	explicit operator double() const {
+		//negate via the unsigned magnitude, which is also correct for the most negative value
+		WideInt m = isNegative() ? -*this : *this;
+		double r = 0;
+		for (int i = Limbs - 1; i >= 0; i--)
+			r = r * 18446744073709551616.0 + (double) m.limb[i];
+		return isNegative() ? -r : r;
+	}
+
+	std::string toString() const {
+		if (isZero())
+			return "0";
+		WideInt v = *this;
+		bool neg = isNegative();
+		if (neg)
+			v = -v;		//note: the most negative value negates to itself, and is then printed via its unsigned magnitude
+		std::string digits;
+		const uint64_t chunk = 10000000000000000000ULL;		//10^19
+		while (!v.isZero()) {
+			uint64_t rem = 0;
+			for (int i = v.usedLimbs() - 1; i >= 0; i--)
+				v.limb[i] = div128(rem, v.limb[i], chunk, rem);
+			for (int d = 0; d < 19 && (rem || !v.isZero()); d++) {
+				digits.push_back('0' + (char) (rem % 10));
+				rem /= 10;
+			}
+		}
+		if (neg)
+			digits.push_back('-');
+		return std::string(digits.rbegin(), digits.rend());
+	}
+
+	WideInt & operator+=(const WideInt & o) {
+		uint64_t carry = 0;
+		for (int i = 0; i < Limbs; i++) {
+			uint64_t a = limb[i];
+			uint64_t s = a + o.limb[i];
+			uint64_t c1 = s < a;
+			limb[i] = s + carry;
+			carry = c1 | (limb[i] < s);
+		}
+		return *this;
+	}
+	WideInt & operator-=(const WideInt & o) {
+		uint64_t borrow = 0;
+		for (int i = 0; i < Limbs; i++) {
+			uint64_t a = limb[i];
+			uint64_t d = a - o.limb[i];
+			uint64_t b1 = d > a;
+			limb[i] = d - borrow;
+			borrow = b1 | (limb[i] > d);
+		}
+		return *this;
+	}
+	WideInt & operator*=(const WideInt & o) {
+		//schoolbook multiplication, truncated to Limbs limbs (which is correct for two's complement)
+		uint64_t r[Limbs];
+		for (int i = 0; i < Limbs; i++)
+			r[i] = 0;
+		for (int i = 0; i < Limbs; i++) {
+			if (!limb[i])
+				continue;
+			uint64_t carry = 0;
+			for (int j = 0; i + j < Limbs; j++) {
+				uint64_t hi, lo;
+				mul64(limb[i], o.limb[j], hi, lo);
+				lo += carry;
+				hi += lo < carry;
+				r[i + j] += lo;
+				hi += r[i + j] < lo;
+				carry = hi;
+			}
+		}
+		for (int i = 0; i < Limbs; i++)
+			limb[i] = r[i];
+		return *this;
+	}
+	//Truncating division, as for int64_t.
+	WideInt & operator/=(const WideInt & o) {
+		bool neg_n = isNegative(), neg_d = o.isNegative();
+		WideInt q, r;
+		udivmod(neg_n ? -*this : *this, neg_d ? -o : o, q, r);
+		*this = (neg_n != neg_d) ? -q : q;
+		return *this;
+	}
+	//The remainder has the sign of the dividend, as for int64_t.
+	WideInt & operator%=(const WideInt & o) {
+		bool neg_n = isNegative(), neg_d = o.isNegative();
+		WideInt q, r;
+		udivmod(neg_n ? -*this : *this, neg_d ? -o : o, q, r);
+		*this = neg_n ? -r : r;
+		return *this;
+	}
+	WideInt & operator<<=(int n) {
+		if (n <= 0)
+			return *this;
+		if (n >= bits)
+			return *this = WideInt();
+		int ls = n / 64, bs = n % 64;
+		for (int i = Limbs - 1; i >= 0; i--) {
+			uint64_t v = i - ls >= 0 ? limb[i - ls] << bs : 0;
+			if (bs && i - ls - 1 >= 0)
+				v |= limb[i - ls - 1] >> (64 - bs);
+			limb[i] = v;
+		}
+		return *this;
+	}
+	//Arithmetic shift (the sign is extended), as for int64_t.
+	WideInt & operator>>=(int n) {
+		if (n <= 0)
+			return *this;
+		uint64_t ext = isNegative() ? ~(uint64_t) 0 : 0;
+		if (n >= bits) {
+			for (int i = 0; i < Limbs; i++)
+				limb[i] = ext;
+			return *this;
+		}
+		int ls = n / 64, bs = n % 64;
+		for (int i = 0; i < Limbs; i++) {
+			uint64_t lo = i + ls < Limbs ? limb[i + ls] : ext;
+			uint64_t hi = i + ls + 1 < Limbs ? limb[i + ls + 1] : ext;
+			limb[i] = bs ? (lo >> bs) | (hi << (64 - bs)) : lo;
+		}
+		return *this;
+	}
+	WideInt & operator&=(const WideInt & o) {
+		for (int i = 0; i < Limbs; i++)
+			limb[i] &= o.limb[i];
+		return *this;
+	}
+	WideInt & operator|=(const WideInt & o) {
+		for (int i = 0; i < Limbs; i++)
+			limb[i] |= o.limb[i];
+		return *this;
+	}
+	WideInt & operator^=(const WideInt & o) {
+		for (int i = 0; i < Limbs; i++)
+			limb[i] ^= o.limb[i];
+		return *this;
+	}
+	WideInt & operator++() {
+		for (int i = 0; i < Limbs; i++)
+			if (++limb[i] != 0)
+				break;
+		return *this;
+	}
+	WideInt & operator--() {
+		for (int i = 0; i < Limbs; i++)
+			if (limb[i]-- != 0)
+				break;
+		return *this;
+	}
+	WideInt operator++(int) {
+		WideInt r = *this;
+		++*this;
+		return r;
+	}
+	WideInt operator--(int) {
+		WideInt r = *this;
+		--*this;
+		return r;
+	}
+	WideInt operator~() const {
+		WideInt r;
+		for (int i = 0; i < Limbs; i++)
+			r.limb[i] = ~limb[i];
+		return r;
+	}
+	WideInt operator-() const {
+		WideInt r = ~*this;
+		return ++r;
+	}
+	WideInt operator+() const {
+		return *this;
+	}
+	bool operator!() const {
+		return isZero();
+	}
+
+	//The binary operators are friends (rather than members), so that integer constants convert on either side.
+	friend inline WideInt operator+(WideInt a, const WideInt & b) {
+		return a += b;
+	}
+	friend inline WideInt operator-(WideInt a, const WideInt & b) {
+		return a -= b;
+	}
+	friend inline WideInt operator*(WideInt a, const WideInt & b) {
+		return a *= b;
+	}
+	friend inline WideInt operator/(WideInt a, const WideInt & b) {
+		return a /= b;
+	}
+	friend inline WideInt operator%(WideInt a, const WideInt & b) {
+		return a %= b;
+	}
+	friend inline WideInt operator&(WideInt a, const WideInt & b) {
+		return a &= b;
+	}
+	friend inline WideInt operator|(WideInt a, const WideInt & b) {
+		return a |= b;
+	}
+	friend inline WideInt operator^(WideInt a, const WideInt & b) {
+		return a ^= b;
+	}
+	friend inline WideInt operator<<(WideInt a, int n) {
+		return a <<= n;
+	}
+	friend inline WideInt operator>>(WideInt a, int n) {
+		return a >>= n;
+	}
+	friend inline bool operator==(const WideInt & a, const WideInt & b) {
+		for (int i = 0; i < Limbs; i++)
+			if (a.limb[i] != b.limb[i])
+				return false;
+		return true;
+	}
+	friend inline bool operator!=(const WideInt & a, const WideInt & b) {
+		return !(a == b);
+	}
+	friend inline bool operator<(const WideInt & a, const WideInt & b) {
+		//the top limb compares as signed, the rest as unsigned
+		if (a.limb[Limbs - 1] != b.limb[Limbs - 1])
+			return (int64_t) a.limb[Limbs - 1] < (int64_t) b.limb[Limbs - 1];
+		for (int i = Limbs - 2; i >= 0; i--)
+			if (a.limb[i] != b.limb[i])
+				return a.limb[i] < b.limb[i];
+		return false;
+	}
+	friend inline bool operator>(const WideInt & a, const WideInt & b) {
+		return b < a;
+	}
+	friend inline bool operator<=(const WideInt & a, const WideInt & b) {
+		return !(b < a);
+	}
+	friend inline bool operator>=(const WideInt & a, const WideInt & b) {
+		return !(a < b);
+	}
+	friend inline std::ostream & operator<<(std::ostream & out, const WideInt & w) {
+		return out << w.toString();
+	}
+	friend inline WideInt abs(const WideInt & w) {
+		return w.isNegative() ? -w : w;
+	}
+};
+
+}
+
+namespace std {
+template<int Limbs>
+class numeric_limits<Monosat::WideInt<Limbs>> {
+public:
+	static constexpr bool is_specialized = true;
+	static constexpr bool is_signed = true;
+	static constexpr bool is_integer = true;
+	static constexpr bool is_exact = true;
+	static constexpr bool has_infinity = false;
+	static constexpr bool has_quiet_NaN = false;
+	static constexpr bool has_signaling_NaN = false;
+	static constexpr bool is_bounded = true;
+	static constexpr bool is_modulo = false;
+	static constexpr int radix = 2;
+	static constexpr int digits = Limbs * 64 - 1;
+	static constexpr int digits10 = (int) (digits * 0.30102999566398119521);
+	static Monosat::WideInt<Limbs> min() {
+		return Monosat::WideInt<Limbs>::bit(Limbs * 64 - 1);
+	}
+	static Monosat::WideInt<Limbs> lowest() {
+		return min();
+	}
+	static Monosat::WideInt<Limbs> max() {
+		return Monosat::WideInt<Limbs>::mask(Limbs * 64 - 1);
+	}
+	static Monosat::WideInt<Limbs> epsilon() {
+		return 0;
+	}
+	static Monosat::WideInt<Limbs> infinity() {
+		return 0;
+	}
+};
+}
+
+#endif /* WIDEINT_H_ */
@@ -21,6 +21,7 @@
  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  **************************************************************************************************/
 
+#include "monosat/mtl/Sort.h"
 #include "monosat/simp/SimpSolver.h"
 
 using namespace Monosat;
@@ -40,6 +41,14 @@ static IntOption opt_clause_lim(_cat, "cl-lim",
 static IntOption opt_subsumption_lim(_cat, "sub-lim",
 									 "Do not check if subsumption against a clause larger than this. -1 means no limit.", 1000,
 									 IntRange(-1, INT32_MAX));
+static BoolOption opt_inprocess(_cat, "inprocess",
+								"Simplify the clause database between restarts (failed literal probing, vivification and subsumption of learnt clauses, and variable elimination while preprocessing is enabled).",
+								false);
+static IntOption opt_inprocess_conflicts(_cat, "inprocess-conflicts", "Number of conflicts between inprocessing rounds.",
+										 10000, IntRange(1, INT32_MAX));
+static DoubleOption opt_inprocess_effort(_cat, "inprocess-effort",
+										 "Propagations allowed in each inprocessing round, as a fraction of the propagations made by search since the previous round.",
+										 0.1, DoubleRange(0, false, HUGE_VAL, false));
 static DoubleOption opt_simp_garbage_frac(_cat, "monosat/simp-gc-frac",
 										  "The fraction of wasted memory allowed before a garbage collection is triggered during simplification.", 0.5,
 										  DoubleRange(0, false, HUGE_VAL, false));
@@ -49,7 +58,8 @@ static DoubleOption opt_simp_garbage_frac(_cat, "monosat/simp-gc-frac",
 
 SimpSolver::SimpSolver() :
 		grow(opt_grow), clause_lim(opt_clause_lim), subsumption_lim(opt_subsumption_lim), simp_garbage_frac(
-		opt_simp_garbage_frac), use_asymm(opt_use_asymm), use_rcheck(opt_use_rcheck), use_elim(opt_use_elim), merges(
+		opt_simp_garbage_frac), use_asymm(opt_use_asymm), use_rcheck(opt_use_rcheck), use_elim(opt_use_elim), use_inprocessing(opt_inprocess), inprocess_conflicts(
+		opt_inprocess_conflicts), inprocess_effort(opt_inprocess_effort), merges(
 		0), asymm_lits(0), eliminated_vars(0), elimorder(1), use_simplification(true), occurs(
 		ClauseDeleted(ca)), elim_heap(ElimLt(n_occ)), bwdsub_assigns(0), n_touched(0) {
 	vec<Lit> dummy(1, lit_Undef);
@@ -110,6 +120,8 @@ lbool SimpSolver::solve_(bool do_simp, bool turn_off_simp) {
 	lbool result = l_True;
 	clearInterrupt();
 	cancelUntil(0);
+	inprocess_search_props = propagations;
+	inprocess_search_start = cpuTime();
 	do_simp &= ok && use_simplification;
 	if (do_simp) {
 		if(pbsolver){
@@ -716,6 +728,333 @@ bool SimpSolver::eliminate(bool turn_off_elim) {
 	return ok;
 }
 
+//=================================================================================================
+// Inprocessing:
+
+void SimpSolver::removeLearnt(CRef cr) {
+	assert(ca[cr].learnt());
+	//Learnt clauses are not in the occurrence lists, so bypass SimpSolver::removeClause.
+	Solver::removeClause(cr);
+}
+
+// Replace the literals of the learnt clause 'cr' with 'lits', which must be a strict subset of them, all unassigned
+// at level 0. Returns false if this made the solver inconsistent.
+bool SimpSolver::shrinkLearnt(CRef cr, const vec<Lit>& lits) {
+	assert(decisionLevel() == 0);
+	assert(lits.size() < ca[cr].size());
+	if (lits.size() == 0) {
+		return ok = false;
+	} else if (lits.size() == 1) {
+		removeLearnt(cr);
+		if (value(lits[0]) == l_False)
+			return ok = false;
+		else if (value(lits[0]) == l_Undef)
+			uncheckedEnqueue(lits[0]);
+		return ok = (propagate(!disable_theories && opt_propagate_theories_during_simplification) == CRef_Undef);
+	}
+	detachClause(cr, true);
+	Clause& c = ca[cr];
+	for (int i = 0; i < lits.size(); i++)
+		c[i] = lits[i];
+	c.shrink(c.size() - lits.size());
+	attachClause(cr);
+	return true;
+}
+
+// Backward subsumption and self-subsuming resolution of learnt clauses, using both learnt and original clauses
+// as subsumers. Occurrence lists are built over the learnt clauses for the duration of the pass.
+bool SimpSolver::subsumeLearnts() {
+	assert(decisionLevel() == 0);
+	inprocess_occs.growTo(nVars() * 2);
+	inprocess_seen.growTo(nVars() * 2, 0);
+	for (int i = 0; i < inprocess_occs.size(); i++)
+		inprocess_occs[i].clear();
+
+	vec<CRef> subsumers;
+	for (CRef cr : learnts) {
+		const Clause& c = ca[cr];
+		if (c.mark())
+			continue;
+		subsumers.push(cr);
+		for (Lit l : c)
+			inprocess_occs[toInt(l)].push(cr);
+	}
+	for (CRef cr : clauses) {
+		const Clause& c = ca[cr];
+		if (!c.mark() && (subsumption_lim == -1 || c.size() < subsumption_lim))
+			subsumers.push(cr);
+	}
+	sort(subsumers, [&](CRef a, CRef b) {return ca[a].size() < ca[b].size();});
+
+	vec<Lit> lits;
+	for (CRef cr : subsumers) {
+		if (ca[cr].mark())
+			continue;
+		if (asynch_interrupt)
+			break;
+		Lit best = lit_Undef;
+		for (Lit l : ca[cr]) {
+			inprocess_seen[toInt(l)] = 1;
+			if (best == lit_Undef
+					|| inprocess_occs[toInt(l)].size() + inprocess_occs[toInt(~l)].size()
+							< inprocess_occs[toInt(best)].size() + inprocess_occs[toInt(~best)].size())
+				best = l;
+		}
+		int csize = ca[cr].size();
+		for (int polarity = 0; polarity < 2; polarity++) {
+			vec<CRef>& occs = inprocess_occs[toInt(polarity ? ~best : best)];
+			for (int k = 0; k < occs.size(); k++) {
+				CRef dr = occs[k];
+				if (dr == cr)
+					continue;
+				const Clause& d = ca[dr];
+				if (d.mark() || d.size() < csize || locked(d))
+					continue;
+				int matched = 0;
+				int flipped = 0;
+				Lit flip = lit_Undef;
+				for (Lit l : d) {
+					if (inprocess_seen[toInt(l)]) {
+						matched++;
+					} else if (inprocess_seen[toInt(~l)]) {
+						flipped++;
+						flip = l;
+					}
+				}
+				if (matched == csize) {
+					stats_inprocess_subsumed++;
+					removeLearnt(dr);
+				} else if (matched == csize - 1 && flipped == 1) {
+					stats_inprocess_strengthened++;
+					lits.clear();
+					bool sat = false;
+					for (Lit l : d) {
+						if (l == flip || value(l) == l_False)
+							continue;
+						if (value(l) == l_True)
+							sat = true;
+						lits.push(l);
+					}
+					if (sat) {
+						removeLearnt(dr);
+					} else if (!shrinkLearnt(dr, lits)) {
+						for (Lit l : ca[cr])
+							inprocess_seen[toInt(l)] = 0;
+						return false;
+					}
+				}
+			}
+		}
+		for (Lit l : ca[cr])
+			inprocess_seen[toInt(l)] = 0;
+	}
+	return true;
+}
+
+// Vivification: assign the negation of each literal of a learnt clause in turn; if propagation then produces
+// a conflict (or makes a later literal of the clause true), the remaining literals are redundant.
+// The most active learnt clauses are vivified first.
+bool SimpSolver::vivifyLearnts(uint64_t prop_limit) {
+	assert(decisionLevel() == 0);
+	vec<CRef> candidates;
+	for (CRef cr : learnts) {
+		if (!ca[cr].mark() && ca[cr].size() > 2)
+			candidates.push(cr);
+	}
+	sort(candidates, [&](CRef a, CRef b) {return ca[a].activity() > ca[b].activity();});
+
+	vec<Lit> lits;
+	vec<Lit> kept;
+	for (CRef cr : candidates) {
+		if (propagations >= prop_limit || asynch_interrupt)
+			break;
+		if (ca[cr].mark() || locked(ca[cr]))
+			continue;
+		lits.clear();
+		bool sat = false;
+		for (Lit l : ca[cr]) {
+			if (value(l) == l_True)
+				sat = true;
+			else if (value(l) == l_Undef)
+				lits.push(l);
+		}
+		if (sat) {
+			removeLearnt(cr);
+			continue;
+		}
+		//propagation below may reorder the literals of this clause, so work from the copy in 'lits'.
+		kept.clear();
+		newDecisionLevel();
+		for (int i = 0; i < lits.size(); i++) {
+			Lit l = lits[i];
+			if (value(l) == l_True) {
+				kept.push(l);
+				break;
+			} else if (value(l) == l_False) {
+				continue;
+			}
+			kept.push(l);
+			if (i == lits.size() - 1)
+				break;
+			uncheckedEnqueue(~l);
+			//only clausal propagation is used here: theory conflicts learnt at this level may backtrack the solver
+			//and re-assign literals below it, after which the remaining assignment no longer follows from 'kept'.
+			if (propagate(false) != CRef_Undef)
+				break;
+		}
+		cancelUntil(0);
+		if (kept.size() < ca[cr].size()) {
+			stats_inprocess_vivified_lits += ca[cr].size() - kept.size();
+			if (!shrinkLearnt(cr, kept))
+				return false;
+		}
+	}
+	return true;
+}
+
+// Failed literal probing: if assigning a literal leads to a conflict, its negation holds at level 0.
+// Literals implied by both polarities of the probed variable also hold at level 0.
+bool SimpSolver::probe(uint64_t prop_limit) {
+	assert(decisionLevel() == 0);
+	inprocess_seen.growTo(nVars() * 2, 0);
+	bool propagate_theories = !disable_theories && opt_propagate_theories_during_simplification;
+	vec<Lit> implied;
+	vec<Lit> necessary;
+	for (int n = 0; n < nVars() && propagations < prop_limit && !asynch_interrupt; n++) {
+		if (probe_next >= nVars())
+			probe_next = 0;
+		Var v = probe_next++;
+		if (value(v) != l_Undef || isEliminated(v) || !decision[v])
+			continue;
+		Lit failed = lit_Undef;
+		bool aborted = false;
+		implied.clear();
+		necessary.clear();
+		for (int polarity = 0; polarity < 2 && failed == lit_Undef && !aborted; polarity++) {
+			Lit p = mkLit(v, polarity);
+			newDecisionLevel();
+			uncheckedEnqueue(p);
+			CRef confl = propagate(propagate_theories);
+			//theory variables may have been created during propagation
+			inprocess_seen.growTo(nVars() * 2, 0);
+			if (decisionLevel() == 0) {
+				//a theory clause backtracked the solver past the probing level
+				aborted = true;
+			} else if (confl != CRef_Undef) {
+				failed = p;
+			} else {
+				for (int i = trail_lim[0] + 1; i < trail.size(); i++) {
+					Lit q = trail[i];
+					if (polarity == 0) {
+						inprocess_seen[toInt(q)] = 1;
+						implied.push(q);
+					} else if (inprocess_seen[toInt(q)]) {
+						necessary.push(q);
+					}
+				}
+			}
+			cancelUntil(0);
+		}
+		for (Lit q : implied)
+			inprocess_seen[toInt(q)] = 0;
+
+		if (aborted) {
+			//no conclusions can be drawn from this variable
+		} else if (failed != lit_Undef) {
+			stats_inprocess_failed_lits++;
+			if (value(failed) == l_Undef)
+				uncheckedEnqueue(~failed);
+			else if (value(failed) == l_True)
+				return ok = false;
+		} else {
+			for (Lit q : necessary) {
+				if (value(q) == l_Undef) {
+					stats_inprocess_necessary_lits++;
+					uncheckedEnqueue(q);
+				}
+			}
+		}
+		if (propagate(propagate_theories) != CRef_Undef)
+			return ok = false;
+	}
+	return true;
+}
+
+bool SimpSolver::inprocess() {
+	if (!use_inprocessing || conflicts < next_inprocess || only_propagate_assumptions)
+		return true;
+	assert(decisionLevel() == 0);
+	double start = cpuTime();
+	if (start > inprocess_search_start) {
+		double rate = (propagations - inprocess_search_props) / (start - inprocess_search_start);
+		if (stats_prop_rate_initial < 0)
+			stats_prop_rate_initial = rate;
+		stats_prop_rate_last = rate;
+	}
+	uint64_t effort = (uint64_t) ((propagations - inprocess_search_props) * inprocess_effort);
+	uint64_t prop_limit = propagations + (effort > 10000 ? effort : 10000);
+	int64_t n_clauses = nClauses() + nLearnts();
+	int64_t n_lits = clauses_literals + learnts_literals;
+	int n_eliminated = eliminated_vars;
+	stats_inprocess_rounds++;
+
+	//probing and vivification overwrite the saved phases of the variables they assign.
+	vec<char> saved_polarity;
+	polarity.copyTo(saved_polarity);
+
+	bool result = simplify() && subsumeLearnts() && vivifyLearnts(prop_limit) && probe(prop_limit);
+	//Removed learnt clauses are only marked (and freed) above; drop them from the learnt clause list.
+	int i, j;
+	for (i = j = 0; i < learnts.size(); i++)
+		if (ca[learnts[i]].mark() == 0)
+			learnts[j++] = learnts[i];
+	learnts.shrink(i - j);
+
+	if (result && use_simplification && use_elim) {
+		//assumptions must be temporarily frozen, as in solve_()
+		vec<Var> extra_frozen;
+		for (Lit l : assumptions) {
+			if (!frozen[var(l)]) {
+				setFrozen(var(l), true);
+				extra_frozen.push(var(l));
+			}
+		}
+		result = eliminate(false);
+		for (Var v : extra_frozen)
+			setFrozen(v, false);
+	}
+	saved_polarity.copyTo(polarity);
+	if (result)
+		checkGarbage();
+
+	stats_inprocess_eliminated_vars += eliminated_vars - n_eliminated;
+	stats_inprocess_removed_clauses += n_clauses - (nClauses() + nLearnts());
+	stats_inprocess_removed_lits += n_lits - (int64_t) (clauses_literals + learnts_literals);
+	next_inprocess = conflicts + inprocess_conflicts;
+	inprocess_search_props = propagations;
+	inprocess_search_start = cpuTime();
+	stats_inprocess_time += inprocess_search_start - start;
+	if (verbosity >= 1)
+		printf("|  Inprocessing: %8" PRId64 " clauses, %10" PRId64 " literals removed (%.2f s)                 |\n",
+			   n_clauses - (nClauses() + nLearnts()), n_lits - (int64_t) (clauses_literals + learnts_literals),
+			   inprocess_search_start - start);
+	return result;
+}
+
+void SimpSolver::printStats(int detail_level) {
+	Solver::printStats(detail_level);
+	if (use_inprocessing && stats_inprocess_rounds > 0) {
+		printf("inprocessing          : %" PRId64 " rounds (%f s), %" PRId64 " clauses and %" PRId64 " literals removed\n",
+			   stats_inprocess_rounds, stats_inprocess_time, stats_inprocess_removed_clauses,
+			   stats_inprocess_removed_lits);
+		printf("                        %" PRId64 " failed and %" PRId64 " necessary literals, %" PRId64 " learnts subsumed, %" PRId64 " strengthened, %" PRId64 " literals vivified, %" PRId64 " vars eliminated\n",
+			   stats_inprocess_failed_lits, stats_inprocess_necessary_lits, stats_inprocess_subsumed,
+			   stats_inprocess_strengthened, stats_inprocess_vivified_lits, stats_inprocess_eliminated_vars);
+		printf("                        propagation rate %.0f /sec before first round, %.0f /sec before last round\n",
+			   stats_prop_rate_initial, stats_prop_rate_last);
+	}
+}
+
 void SimpSolver::cleanUpClauses() {
 	occurs.cleanAll();
 	int i, j;
@@ -135,6 +135,9 @@ public:
 	bool use_asymm;         // Shrink clauses by asymmetric branching.
 	bool use_rcheck;        // Check if a clause is already implied. Prett costly, and subsumes subsumptions :)
 	bool use_elim;          // Perform variable elimination.
+	bool use_inprocessing;  // Simplify the clause database between restarts.
+	int inprocess_conflicts; // Number of conflicts between inprocessing rounds.
+	double inprocess_effort; // Propagations allowed per inprocessing round, as a fraction of those made by search since the last round.
 
 	// Statistics:
 	//
@@ -142,6 +145,21 @@ public:
 	int asymm_lits;
 	int eliminated_vars;
 
+	int64_t stats_inprocess_rounds = 0;
+	int64_t stats_inprocess_failed_lits = 0;     // Units learnt by failed literal probing.
+	int64_t stats_inprocess_necessary_lits = 0;  // Units implied by both polarities of a probed variable.
+	int64_t stats_inprocess_vivified_lits = 0;   // Literals removed from learnt clauses by vivification.
+	int64_t stats_inprocess_subsumed = 0;        // Learnt clauses removed by subsumption.
+	int64_t stats_inprocess_strengthened = 0;    // Literals removed from learnt clauses by self-subsuming resolution.
+	int64_t stats_inprocess_eliminated_vars = 0;
+	int64_t stats_inprocess_removed_clauses = 0; // Net reduction of the clause database (original and learnt) across all rounds.
+	int64_t stats_inprocess_removed_lits = 0;
+	double stats_inprocess_time = 0;
+	double stats_prop_rate_initial = -1;         // Propagations/s of search before the first inprocessing round.
+	double stats_prop_rate_last = -1;            // Propagations/s of search between the two most recent rounds.
+
+	void printStats(int detail_level = 0) override;
+
 protected:
 
 	// Helper structures:
@@ -194,6 +212,12 @@ protected:
 	vec<char> eliminated;
 	int bwdsub_assigns;
 	int n_touched;
+	uint64_t next_inprocess = 0;
+	uint64_t inprocess_search_props = 0; // Propagations at the end of the last inprocessing round.
+	double inprocess_search_start = 0;   // cpuTime() at the end of the last inprocessing round.
+	Var probe_next = 0;
+	vec<vec<CRef> > inprocess_occs;
+	vec<char> inprocess_seen;
 
 	// Temporaries:
 	//
@@ -217,6 +241,14 @@ protected:
 	void cleanUpClauses();
 	bool implied(const vec<Lit>& c);
 	void relocAll(ClauseAllocator& to);
+
+	// Inprocessing:
+	bool inprocess() override;
+	bool subsumeLearnts();
+	bool vivifyLearnts(uint64_t prop_limit);
+	bool probe(uint64_t prop_limit);
+	bool shrinkLearnt(CRef cr, const vec<Lit>& lits);
+	void removeLearnt(CRef cr);
 };
 
 //=================================================================================================
@@ -323,7 +355,10 @@ inline bool SimpSolver::solve(const vec<Lit>& assumps, bool do_simp, bool turn_o
 
 inline lbool SimpSolver::solveLimited(const vec<Lit>& assumps, bool do_simp, bool turn_off_simp) {
 	assumps.copyTo(assumptions);
-	return solve_(do_simp, turn_off_simp);
+	limited_search = true;
+	lbool val = solve_(do_simp, turn_off_simp);
+	limited_search = false;
+	return val;
 }
 
 //=================================================================================================
@@ -0,0 +1,187 @@
+/****************************************************************************************[AsyncWriter.h]
+ The MIT License (MIT)
+
+ Copyright (c) 2014, Sam Bayless
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ associated documentation files (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or
+ substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **************************************************************************************************/
+
+#ifndef ASYNCWRITER_H_
+#define ASYNCWRITER_H_
+
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Monosat {
+
+/**
+ * Buffers formatted output in large blocks, and hands the blocks to a sink on a background thread.
+ *
+ * The producer formats directly into the current block (no locking, no system calls); full blocks are queued
+ * for the background thread, and recycled once written. At most max_blocks blocks are in flight at once
+ * (so the buffers form a bounded ring), after which the producer waits for the writer to catch up.
+ *
+ * sync() blocks until everything written so far has been passed to the sink, and the flush function has returned;
+ * this is the only point at which output is guaranteed to have reached the sink.
+ * If the sink throws, the error is remembered, further output is discarded, and sync() returns false.
+ */
+class AsyncWriter {
+	std::function<void(const char *, size_t)> sink;
+	std::function<void()> flush_fn;
+	size_t block_size;
+	size_t max_blocks;
+
+	std::vector<char> current;
+	std::mutex mutex;
+	std::condition_variable work_available;
+	std::condition_variable work_done;
+	std::deque<std::vector<char>> queue;
+	std::vector<std::vector<char>> free_blocks;
+	size_t n_blocks = 1;
+	uint64_t sync_requested = 0;
+	uint64_t sync_done = 0;
+	bool stopping = false;
+	bool error = false;
+	std::thread worker;
+
+	void run() {
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true) {
+			work_available.wait(lock, [&] {return stopping || queue.size() || sync_requested > sync_done;});
+			if (queue.size()) {
+				std::vector<char> block = std::move(queue.front());
+				queue.pop_front();
+				bool failed = error;
+				lock.unlock();
+				if (!failed) {
+					try {
+						sink(block.data(), block.size());
+					} catch (...) {
+						failed = true;
+					}
+				}
+				block.clear();
+				lock.lock();
+				error |= failed;
+				free_blocks.push_back(std::move(block));
+				work_done.notify_all();
+			} else if (sync_requested > sync_done) {
+				uint64_t target = sync_requested;
+				bool failed = error;
+				lock.unlock();
+				if (!failed && flush_fn) {
+					try {
+						flush_fn();
+					} catch (...) {
+						failed = true;
+					}
+				}
+				lock.lock();
+				error |= failed;
+				sync_done = target;
+				work_done.notify_all();
+			} else if (stopping) {
+				return;
+			}
+		}
+	}
+
+	//Hand the current block to the writer thread, and take a fresh one.
+	void submit() {
+		if (current.empty())
+			return;
+		std::unique_lock<std::mutex> lock(mutex);
+		while (free_blocks.empty() && n_blocks >= max_blocks) {
+			work_done.wait(lock);
+		}
+		queue.push_back(std::move(current));
+		if (free_blocks.size()) {
+			current = std::move(free_blocks.back());
+			free_blocks.pop_back();
+		} else {
+			n_blocks++;
+			current = std::vector<char>();
+		}
+		current.clear();
+		current.reserve(block_size);
+		work_available.notify_one();
+	}
+
+public:
+	AsyncWriter(std::function<void(const char *, size_t)> sink, std::function<void()> flush, size_t block_size = 1 << 16,
+			size_t max_blocks = 64) :
+			sink(sink), flush_fn(flush), block_size(block_size), max_blocks(max_blocks < 2 ? 2 : max_blocks) {
+		current.reserve(block_size);
+		worker = std::thread([this] {run();});
+	}
+	~AsyncWriter() {
+		sync();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		work_available.notify_one();
+		worker.join();
+	}
+
+	void write(const char * data, size_t len) {
+		current.insert(current.end(), data, data + len);
+		if (current.size() >= block_size)
+			submit();
+	}
+
+	void vwritef(const char * fmt, va_list args) {
+		size_t start = current.size();
+		va_list args2;
+		va_copy(args2, args);
+		current.resize(start + 256);
+		int n = vsnprintf(current.data() + start, 256, fmt, args);
+		if (n >= 256) {
+			current.resize(start + n + 1);
+			vsnprintf(current.data() + start, n + 1, fmt, args2);
+		}
+		va_end(args2);
+		current.resize(start + (n > 0 ? n : 0));
+		if (current.size() >= block_size)
+			submit();
+	}
+
+	//Block until all output so far has been passed to the sink and flushed. Returns false if any write failed.
+	bool sync() {
+		submit();
+		std::unique_lock<std::mutex> lock(mutex);
+		uint64_t ticket = ++sync_requested;
+		work_available.notify_one();
+		work_done.wait(lock, [&] {return sync_done >= ticket;});
+		return !error;
+	}
+
+	bool failed() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return error;
+	}
+};
+
+}
+
+#endif /* ASYNCWRITER_H_ */
@@ -0,0 +1,128 @@
+/****************************************************************************************[ThreadPool.h]
+ The MIT License (MIT)
+
+ Copyright (c) 2014, Sam Bayless
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ associated documentation files (the "Software"), to deal in the Software without restriction,
+ including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or
+ substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **************************************************************************************************/
+
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Monosat {
+
+/**
+ * A minimal fixed-size pool of worker threads, supporting only blocking 'parallel for' loops.
+ * The calling thread participates in the loop, so a pool of n threads starts n-1 workers.
+ * Tasks are handed out dynamically (in increasing index order), so the assignment of tasks to threads
+ * is non-deterministic; callers are responsible for merging results in a deterministic order.
+ */
+class ThreadPool {
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable work_available;
+	std::condition_variable work_done;
+
+	std::function<void(int)> task;
+	std::atomic<int> next_task;
+	int n_tasks = 0;
+	int n_busy = 0;
+	uint64_t generation = 0;
+	bool stopping = false;
+
+	void runTasks() {
+		int i;
+		while ((i = next_task.fetch_add(1)) < n_tasks) {
+			task(i);
+		}
+	}
+
+	void workerLoop() {
+		uint64_t last_generation = 0;
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				work_available.wait(lock, [&] {return stopping || generation != last_generation;});
+				if (stopping)
+					return;
+				last_generation = generation;
+			}
+			runTasks();
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				if (--n_busy == 0)
+					work_done.notify_one();
+			}
+		}
+	}
+
+public:
+	ThreadPool(int n_threads) :
+			next_task(0) {
+		for (int i = 1; i < n_threads; i++) {
+			workers.emplace_back(&ThreadPool::workerLoop, this);
+		}
+	}
+
+	~ThreadPool() {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		work_available.notify_all();
+		for (std::thread & t : workers)
+			t.join();
+	}
+
+	int nThreads() const {
+		return workers.size() + 1;
+	}
+
+	//Call fn(i) for each i in [0,n), returning only once all calls have completed.
+	//Not re-entrant: fn must not call parallel_for on the same pool.
+	void parallel_for(int n, const std::function<void(int)> & fn) {
+		if (workers.size() == 0 || n <= 1) {
+			for (int i = 0; i < n; i++)
+				fn(i);
+			return;
+		}
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			task = fn;
+			n_tasks = n;
+			next_task = 0;
+			n_busy = workers.size();
+			generation++;
+		}
+		work_available.notify_all();
+		runTasks();
+		std::unique_lock<std::mutex> lock(mutex);
+		work_done.wait(lock, [&] {return n_busy == 0;});
+		task = nullptr;
+	}
+};
+
+}
+
+#endif /* THREADPOOL_H_ */
@@ -0,0 +1,69 @@
+import functools
+import math
+from monosat import *
+import os
+from random import shuffle
+import random
+import random
+import sys
+import itertools
+
+#Random resource-constrained scheduling instance, in which each start time bitvector has hundreds of comparisons to constants.
+#Useful as a benchmark for the propagation of bitvector comparisons.
+
+if __name__ == "__main__":
+    seed = random.randint(1,100000)
+    filename=None
+
+    if len(sys.argv)>1:
+        filename=sys.argv[1]
+    if len(sys.argv)>2:
+        seed=int(sys.argv[2])
+
+
+print("begin encode");
+
+if filename is not None:
+    Monosat().setOutputFile(filename)
+random.seed(seed)
+print("RandomSeed=" + str(seed))
+
+width=10
+ntasks=60
+capacity=4
+
+starts=[]
+durations=[]
+for i in range(ntasks):
+    durations.append(random.randint(4,16))
+#leave only a little slack over a perfect packing of the tasks
+horizon = sum(durations)//capacity + 1
+for i in range(ntasks):
+    starts.append(BitVector(width))
+    Assert(starts[i] + durations[i] <= horizon)
+
+#random precedences between tasks
+for i in range(ntasks):
+    for j in range(i+1,ntasks):
+        if random.random()<0.1:
+            Assert(starts[i] + durations[i] <= starts[j])
+
+#at each time step, at most 'capacity' tasks may be running
+for t in range(horizon):
+    running=[]
+    for i in range(ntasks):
+        if durations[i]>t:
+            running.append(starts[i] <= t)
+        else:
+            running.append(And(starts[i] <= t, starts[i] > t-durations[i]))
+    AssertLessEqPB(running, capacity)
+
+result =Solve()
+
+print("Result is " + str(result))
+
+if result:
+    print(" ".join(str(bv.value()) for bv in starts))
+    sys.exit(10)
+else:
+    sys.exit(20)